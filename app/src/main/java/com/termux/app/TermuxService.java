@@ -46,11 +46,22 @@ import com.termux.shared.shell.command.ExecutionCommand;
 import com.termux.shared.shell.command.ExecutionCommand.Runner;
 import com.termux.shared.shell.command.ExecutionCommand.ShellCreateMode;
 import com.termux.terminal.TerminalEmulator;
+import com.termux.terminal.TerminalMemoryGovernor;
 import com.termux.terminal.TerminalSession;
 import com.termux.terminal.TerminalSessionClient;
-
+import com.termux.terminal.TerminalTrace;
+
+import java.io.BufferedWriter;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.OutputStreamWriter;
+import java.io.Writer;
+import java.nio.charset.StandardCharsets;
 import java.util.ArrayList;
 import java.util.List;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
 
 /**
  * A service holding a list of {@link TermuxSession} in {@link TermuxShellManager#mTermuxSessions} and background {@link AppShell}
@@ -98,6 +109,18 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
      */
     private TermuxShellManager mShellManager;
 
+    /**
+     * Keeps the transcripts of all terminal sessions within a quarter of the max heap size, trimming
+     * the least recently used background sessions first.
+     */
+    private final TerminalMemoryGovernor mTerminalMemoryGovernor = new TerminalMemoryGovernor(Runtime.getRuntime().maxMemory() / 4);
+
+    /**
+     * Runs the {@link TERMUX_SERVICE#ACTION_TRACE_START} and {@link TERMUX_SERVICE#ACTION_TRACE_STOP} actions in order,
+     * so that a trace is never cleared or started while the previous one is being exported.
+     */
+    private final ExecutorService mTraceExecutor = Executors.newSingleThreadExecutor(runnable -> new Thread(runnable, "TermuxTrace"));
+
     /** The wake lock and wifi lock are always acquired and released together. */
     private PowerManager.WakeLock mWakeLock;
     private WifiManager.WifiLock mWifiLock;
@@ -150,6 +173,22 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
                     Logger.logDebug(LOG_TAG, "ACTION_WAKE_UNLOCK intent received");
                     actionReleaseWakeLock(true);
                     break;
+                case TERMUX_SERVICE.ACTION_TRACE_START:
+                    Logger.logDebug(LOG_TAG, "ACTION_TRACE_START intent received");
+                    actionStartTrace();
+                    break;
+                case TERMUX_SERVICE.ACTION_TRACE_STOP:
+                    Logger.logDebug(LOG_TAG, "ACTION_TRACE_STOP intent received");
+                    actionStopTrace(intent);
+                    break;
+                case TERMUX_SERVICE.ACTION_RECORDING_START:
+                    Logger.logDebug(LOG_TAG, "ACTION_RECORDING_START intent received");
+                    actionStartRecording(intent);
+                    break;
+                case TERMUX_SERVICE.ACTION_RECORDING_STOP:
+                    Logger.logDebug(LOG_TAG, "ACTION_RECORDING_STOP intent received");
+                    actionStopRecording();
+                    break;
                 case TERMUX_SERVICE.ACTION_SERVICE_EXECUTE:
                     Logger.logDebug(LOG_TAG, "ACTION_SERVICE_EXECUTE intent received");
                     actionServiceExecute(intent);
@@ -179,9 +218,19 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
 
         SystemEventReceiver.unregisterPackageUpdateEvents(this);
 
+        // Lets a pending trace export finish
+        mTraceExecutor.shutdown();
+
         runStopForeground();
     }
 
+    @Override
+    public void onTrimMemory(int level) {
+        super.onTrimMemory(level);
+        Logger.logDebug(LOG_TAG, "onTrimMemory: level=" + level + ", transcripts=" + mTerminalMemoryGovernor.getTotalMemoryUsage() + " bytes");
+        mTerminalMemoryGovernor.onTrimMemory(level);
+    }
+
     @Override
     public IBinder onBind(Intent intent) {
         Logger.logVerbose(LOG_TAG, "onBind");
@@ -354,6 +403,72 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
         Logger.logDebug(LOG_TAG, "WakeLocks released successfully");
     }
 
+    /** Process {@link TERMUX_SERVICE#ACTION_TRACE_START} intent to discard old trace events and start tracing. */
+    private void actionStartTrace() {
+        // Run in order with the export of a previous trace, which must not see the events of this one
+        mTraceExecutor.execute(() -> {
+            TerminalTrace.setEnabled(false);
+            TerminalTrace.clear();
+            TerminalTrace.setEnabled(true);
+            Logger.logInfo(LOG_TAG, "Started tracing terminal sessions");
+        });
+    }
+
+    /**
+     * Process {@link TERMUX_SERVICE#ACTION_TRACE_STOP} intent to stop tracing and write the trace as Chrome trace
+     * JSON to {@link TERMUX_SERVICE#EXTRA_TRACE_FILE_PATH}, or {@link TERMUX_SERVICE#DEFAULT_TRACE_FILE_PATH}.
+     */
+    private void actionStopTrace(Intent intent) {
+        String filePath = intent.getStringExtra(TERMUX_SERVICE.EXTRA_TRACE_FILE_PATH);
+        final String traceFilePath = DataUtils.isNullOrEmpty(filePath) ? TERMUX_SERVICE.DEFAULT_TRACE_FILE_PATH : filePath;
+        final int processId = android.os.Process.myPid();
+        mTraceExecutor.execute(() -> {
+            TerminalTrace.setEnabled(false);
+            try (Writer writer = new BufferedWriter(new OutputStreamWriter(new FileOutputStream(traceFilePath), StandardCharsets.UTF_8))) {
+                TerminalTrace.writeChromeTraceJson(writer, processId);
+                Logger.logInfo(LOG_TAG, "Wrote terminal trace to \"" + traceFilePath + "\"");
+            } catch (IOException e) {
+                Logger.logStackTraceWithMessage(LOG_TAG, "Failed to write terminal trace to \"" + traceFilePath + "\"", e);
+            }
+        });
+    }
+
+    /**
+     * Process {@link TERMUX_SERVICE#ACTION_RECORDING_START} intent to record the output of the terminal session in
+     * foreground, or the latest session if none is, to {@link TERMUX_SERVICE#EXTRA_RECORDING_FILE_PATH}, or
+     * {@link TERMUX_SERVICE#DEFAULT_RECORDING_FILE_PATH}. The recording can be replayed with
+     * {@link com.termux.terminal.TerminalSessionRecording}.
+     */
+    private void actionStartRecording(Intent intent) {
+        TerminalSession session = mTerminalMemoryGovernor.getForegroundSession();
+        if (session == null && !mShellManager.mTermuxSessions.isEmpty())
+            session = mShellManager.mTermuxSessions.get(mShellManager.mTermuxSessions.size() - 1).getTerminalSession();
+        if (session == null) {
+            Logger.logError(LOG_TAG, "Not starting recording since there is no terminal session");
+            return;
+        }
+
+        String filePath = intent.getStringExtra(TERMUX_SERVICE.EXTRA_RECORDING_FILE_PATH);
+        String recordingFilePath = DataUtils.isNullOrEmpty(filePath) ? TERMUX_SERVICE.DEFAULT_RECORDING_FILE_PATH : filePath;
+        try {
+            session.startRecording(new File(recordingFilePath));
+            Logger.logInfo(LOG_TAG, "Started recording terminal session to \"" + recordingFilePath + "\"");
+        } catch (IOException e) {
+            Logger.logStackTraceWithMessage(LOG_TAG, "Failed to start recording terminal session to \"" + recordingFilePath + "\"", e);
+        }
+    }
+
+    /** Process {@link TERMUX_SERVICE#ACTION_RECORDING_STOP} intent to stop recording all terminal sessions. */
+    private void actionStopRecording() {
+        for (TermuxSession termuxSession : mShellManager.mTermuxSessions) {
+            TerminalSession session = termuxSession.getTerminalSession();
+            if (session.isRecording()) {
+                session.stopRecording();
+                Logger.logInfo(LOG_TAG, "Stopped recording terminal session");
+            }
+        }
+    }
+
     /** Process {@link TERMUX_SERVICE#ACTION_SERVICE_EXECUTE} intent to execute a shell command in
      * a foreground TermuxSession or in a background TermuxTask. */
     private void actionServiceExecute(Intent intent) {
@@ -606,6 +721,7 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
         }
 
         mShellManager.mTermuxSessions.add(newTermuxSession);
+        mTerminalMemoryGovernor.addSession(newTermuxSession.getTerminalSession());
 
         // Remove the execution command from the pending plugin execution commands list since it has
         // now been processed
@@ -648,6 +764,7 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
                 TermuxPluginUtils.processPluginExecutionCommandResult(this, LOG_TAG, executionCommand);
 
             mShellManager.mTermuxSessions.remove(termuxSession);
+            mTerminalMemoryGovernor.removeSession(termuxSession.getTerminalSession());
 
             // Notify {@link TermuxSessionsListViewController} that sessions list has been updated if
             // activity in is foreground
@@ -878,6 +995,11 @@ public final class TermuxService extends Service implements AppShell.AppShellCli
         return mShellManager.mTermuxSessions.size();
     }
 
+    /** The {@link TerminalMemoryGovernor} of the transcripts of all {@link TermuxSession}s. */
+    public TerminalMemoryGovernor getTerminalMemoryGovernor() {
+        return mTerminalMemoryGovernor;
+    }
+
     public synchronized List<TermuxSession> getTermuxSessions() {
         return mShellManager.mTermuxSessions;
     }
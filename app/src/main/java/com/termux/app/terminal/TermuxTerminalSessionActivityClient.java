@@ -116,6 +116,10 @@ public class TermuxTerminalSessionActivityClient extends TermuxTerminalSessionCl
 
     @Override
     public void onTextChanged(@NonNull TerminalSession changedSession) {
+        TermuxService service = mActivity.getTermuxService();
+        if (service != null)
+            service.getTerminalMemoryGovernor().onSessionTextChanged(changedSession);
+
         if (!mActivity.isVisible()) return;
 
         if (mActivity.getCurrentSession() == changedSession) mActivity.getTerminalView().onScreenUpdated();
@@ -293,6 +297,12 @@ public class TermuxTerminalSessionActivityClient extends TermuxTerminalSessionCl
     public void setCurrentSession(TerminalSession session) {
         if (session == null) return;
 
+        // Keep the full transcript of the displayed session when trimming background sessions. Done before attaching,
+        // so the transcript capacity of a trimmed session is restored before it is resized to the view.
+        TermuxService service = mActivity.getTermuxService();
+        if (service != null)
+            service.getTerminalMemoryGovernor().setForegroundSession(session);
+
         if (mActivity.getTerminalView().attachSession(session)) {
             // notify about switched session if not already displaying the session
             notifyOfSessionChange();
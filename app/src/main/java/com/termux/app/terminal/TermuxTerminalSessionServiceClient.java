@@ -21,6 +21,11 @@ public class TermuxTerminalSessionServiceClient extends TermuxTerminalSessionCli
         this.mService = service;
     }
 
+    @Override
+    public void onTextChanged(@NonNull TerminalSession changedSession) {
+        mService.getTerminalMemoryGovernor().onSessionTextChanged(changedSession);
+    }
+
     @Override
     public void setTerminalShellPid(@NonNull TerminalSession terminalSession, int pid) {
         TermuxSession termuxSession = mService.getTermuxSessionForTerminalSession(terminalSession);
@@ -41,6 +41,7 @@ import com.termux.shared.termux.data.TermuxUrlUtils;
 import com.termux.shared.view.KeyboardUtils;
 import com.termux.shared.view.ViewUtils;
 import com.termux.terminal.KeyHandler;
+import com.termux.terminal.TerminalBufferSnapshot;
 import com.termux.terminal.TerminalEmulator;
 import com.termux.terminal.TerminalSession;
 
@@ -675,13 +676,26 @@ public class TermuxTerminalViewClient extends TermuxTerminalViewClientBase {
         TerminalSession session = mActivity.getCurrentSession();
         if (session == null) return;
 
-        String transcriptText = ShellUtils.getTerminalSessionTranscriptText(session, false, true);
-        if (transcriptText == null) return;
+        // Get the text of a large transcript from a snapshot in the background instead of blocking the main thread
+        final TerminalBufferSnapshot snapshot = ShellUtils.getTerminalSessionTranscriptSnapshot(session);
+        if (snapshot == null) return;
 
-        // See https://github.com/termux/termux-app/issues/1166.
-        transcriptText = DataUtils.getTruncatedCommandOutput(transcriptText, DataUtils.TRANSACTION_SIZE_LIMIT_IN_BYTES, false, true, false).trim();
-        ShareUtils.shareText(mActivity, mActivity.getString(R.string.title_share_transcript),
-            transcriptText, mActivity.getString(R.string.title_share_transcript_with));
+        new Thread("TermuxShareTranscript") {
+            @Override
+            public void run() {
+                // See https://github.com/termux/termux-app/issues/1166. Only the text of the last rows that can be
+                // shared is read, which is then cut at a line start like for the full transcript.
+                final String transcriptText = DataUtils.getTruncatedCommandOutput(
+                    snapshot.getTranscriptTextTail(DataUtils.TRANSACTION_SIZE_LIMIT_IN_BYTES, false, false).trim(),
+                    DataUtils.TRANSACTION_SIZE_LIMIT_IN_BYTES, false, true, false).trim();
+                mActivity.runOnUiThread(() -> {
+                    // The activity may have been closed while the transcript was being read
+                    if (mActivity.isFinishing() || mActivity.isDestroyed()) return;
+                    ShareUtils.shareText(mActivity, mActivity.getString(R.string.title_share_transcript),
+                        transcriptText, mActivity.getString(R.string.title_share_transcript_with));
+                });
+            }
+        }.start();
     }
 
     public void shareSelectedText() {
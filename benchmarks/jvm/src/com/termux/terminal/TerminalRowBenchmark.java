@@ -0,0 +1,278 @@
+package com.termux.terminal;
+
+import java.util.Locale;
+
+/**
+ * Compares {@link TerminalRow} with LegacyTerminalRow, the row before styles were stored in a palette, on a host JVM.
+ * LegacyTerminalRow is generated from git by the Makefile.
+ * <p>
+ * Each benchmark runs passes over a screen of rows and prints one JSON object per line to stdout, with the time per
+ * cell and the average {@link TerminalRow#getMemoryUsage()} of a row afterwards. Pass benchmark names as arguments to
+ * only run those:
+ * <ul>
+ * <li>plain, colored and truecolor clear the rows and write every cell with
+ * {@link TerminalRow#setChar(int, int, long)}, like the emulator does for output, with styles of the given kind.</li>
+ * <li>find_column looks up {@link TerminalRow#findStartOfColumn(int)} of every cell, and selected_text copies the text
+ * of the whole screen like {@link TerminalBuffer#getSelectedText(int, int, int, int)}, on rows with wide and combining
+ * chars that are not modified between passes, like a screen being rendered or selected from.</li>
+ * </ul>
+ */
+public final class TerminalRowBenchmark {
+
+    private static final int COLUMNS = 80;
+    private static final int ROWS = 24;
+    private static final int WARMUP_PASSES = 2_000;
+    private static final int MEASURED_PASSES = 10_000;
+
+    /** The style of a cell, which may change between passes. */
+    private interface CellStyle {
+        long get(int pass, int row, int column);
+    }
+
+    /** Adapts both row implementations, so that they are driven by the same loops. */
+    private interface Row {
+        void clear(long style);
+
+        void setChar(int column, int codePoint, long style);
+
+        long getStyle(int column);
+
+        int findStartOfColumn(int column);
+
+        int getSpaceUsed();
+
+        char[] getText();
+
+        long getMemoryUsage();
+    }
+
+    private static final String[] BENCHMARKS = {"plain", "colored", "truecolor", "find_column", "selected_text"};
+
+    private static boolean isBenchmark(String benchmark) {
+        for (String name : BENCHMARKS)
+            if (name.equals(benchmark)) return true;
+        return false;
+    }
+
+    private static CellStyle getCellStyle(String benchmark) {
+        switch (benchmark) {
+            case "plain":
+                return (pass, row, column) -> TextStyle.NORMAL;
+            case "colored":
+                // Runs of 8 cells in one of the 16 ANSI colors, like `ls --color` or a syntax highlighted file:
+                return (pass, row, column) -> TextStyle.encode((row + column / 8) % 16, TextStyle.COLOR_INDEX_BACKGROUND, 0);
+            case "truecolor":
+                // A different 24-bit color on every cell and pass, like an animated gradient:
+                return (pass, row, column) -> TextStyle.encode(0xff000000 | ((pass & 0xff) << 16) | (row << 8) | column,
+                    TextStyle.COLOR_INDEX_BACKGROUND, 0);
+            default:
+                return null;
+        }
+    }
+
+    private static Row[] createRows(boolean legacy) {
+        Row[] rows = new Row[ROWS];
+        for (int i = 0; i < ROWS; i++) {
+            if (legacy) {
+                final LegacyTerminalRow row = new LegacyTerminalRow(COLUMNS, TextStyle.NORMAL);
+                rows[i] = new Row() {
+                    @Override
+                    public void clear(long style) {
+                        row.clear(style);
+                    }
+
+                    @Override
+                    public void setChar(int column, int codePoint, long style) {
+                        row.setChar(column, codePoint, style);
+                    }
+
+                    @Override
+                    public long getStyle(int column) {
+                        return row.getStyle(column);
+                    }
+
+                    @Override
+                    public int findStartOfColumn(int column) {
+                        return row.findStartOfColumn(column);
+                    }
+
+                    @Override
+                    public int getSpaceUsed() {
+                        return row.getSpaceUsed();
+                    }
+
+                    @Override
+                    public char[] getText() {
+                        return row.mText;
+                    }
+
+                    @Override
+                    public long getMemoryUsage() {
+                        return row.getMemoryUsage();
+                    }
+                };
+            } else {
+                final TerminalRow row = new TerminalRow(COLUMNS, TextStyle.NORMAL);
+                rows[i] = new Row() {
+                    @Override
+                    public void clear(long style) {
+                        row.clear(style);
+                    }
+
+                    @Override
+                    public void setChar(int column, int codePoint, long style) {
+                        row.setChar(column, codePoint, style);
+                    }
+
+                    @Override
+                    public long getStyle(int column) {
+                        return row.getStyle(column);
+                    }
+
+                    @Override
+                    public int findStartOfColumn(int column) {
+                        return row.findStartOfColumn(column);
+                    }
+
+                    @Override
+                    public int getSpaceUsed() {
+                        return row.getSpaceUsed();
+                    }
+
+                    @Override
+                    public char[] getText() {
+                        return row.mText;
+                    }
+
+                    @Override
+                    public long getMemoryUsage() {
+                        return row.getMemoryUsage();
+                    }
+                };
+            }
+        }
+        return rows;
+    }
+
+    /**
+     * Fill the rows with text mixing ascii, wide CJK chars and ascii with a combining accent, shifted on every row so
+     * that the columns where the chars start differ.
+     */
+    private static void fillWithWideAndCombiningChars(Row[] rows) {
+        for (int row = 0; row < ROWS; row++) {
+            Row terminalRow = rows[row];
+            terminalRow.clear(TextStyle.NORMAL);
+            int column = 0;
+            while (column < COLUMNS) {
+                int kind = (row + column) % 12;
+                if (kind < 4 && column < COLUMNS - 1) {
+                    terminalRow.setChar(column, 0x4E00 + kind, TextStyle.NORMAL);
+                    column += 2;
+                } else {
+                    terminalRow.setChar(column, 'a' + column % 26, TextStyle.NORMAL);
+                    // COMBINING ACUTE ACCENT:
+                    if (kind == 5) terminalRow.setChar(column, 0x0301, TextStyle.NORMAL);
+                    column++;
+                }
+            }
+        }
+    }
+
+    /** Write all cells of all rows for the given passes, returning a checksum of the styles so that nothing is elided. */
+    private static long writePasses(Row[] rows, CellStyle cellStyle, int firstPass, int passes) {
+        long checksum = 0;
+        for (int pass = firstPass; pass < firstPass + passes; pass++) {
+            for (int row = 0; row < ROWS; row++) {
+                Row terminalRow = rows[row];
+                // Every fourth pass clears the screen, the others overwrite it like a full screen program redrawing:
+                if (pass % 4 == 0) terminalRow.clear(TextStyle.NORMAL);
+                for (int column = 0; column < COLUMNS; column++)
+                    terminalRow.setChar(column, 'a' + (pass + column) % 26, cellStyle.get(pass, row, column));
+                checksum += terminalRow.getStyle(pass % COLUMNS);
+            }
+        }
+        return checksum;
+    }
+
+    /** Find the start of every column of all rows for the given passes, returning a checksum of the indices. */
+    private static long findColumnPasses(Row[] rows, int passes) {
+        long checksum = 0;
+        for (int pass = 0; pass < passes; pass++) {
+            for (int row = 0; row < ROWS; row++) {
+                Row terminalRow = rows[row];
+                for (int column = 0; column < COLUMNS; column++)
+                    checksum += terminalRow.findStartOfColumn(column);
+            }
+        }
+        return checksum;
+    }
+
+    /**
+     * Copy the text of all rows for the given passes, starting at a column that changes on every pass, like
+     * {@link TerminalBuffer#appendSelectedRowText} does for rows that are not line wrapped. Returns the total length.
+     */
+    private static long selectedTextPasses(Row[] rows, int firstPass, int passes) {
+        long checksum = 0;
+        StringBuilder builder = new StringBuilder();
+        for (int pass = firstPass; pass < firstPass + passes; pass++) {
+            builder.setLength(0);
+            for (int row = 0; row < ROWS; row++) {
+                Row terminalRow = rows[row];
+                int x1Index = terminalRow.findStartOfColumn((row == 0) ? pass % 8 : 0);
+                int x2Index = terminalRow.getSpaceUsed();
+                char[] text = terminalRow.getText();
+                int lastPrintingCharIndex = -1;
+                for (int i = x1Index; i < x2Index; i++)
+                    if (text[i] != ' ') lastPrintingCharIndex = i;
+                if (lastPrintingCharIndex >= x1Index)
+                    builder.append(text, x1Index, lastPrintingCharIndex - x1Index + 1);
+                if (row < ROWS - 1) builder.append('\n');
+            }
+            checksum += builder.length();
+        }
+        return checksum;
+    }
+
+    private static long runPasses(String benchmark, Row[] rows, int firstPass, int passes) {
+        switch (benchmark) {
+            case "find_column":
+                return findColumnPasses(rows, passes);
+            case "selected_text":
+                return selectedTextPasses(rows, firstPass, passes);
+            default:
+                return writePasses(rows, getCellStyle(benchmark), firstPass, passes);
+        }
+    }
+
+    private static void run(String benchmark, boolean legacy) {
+        Row[] rows = createRows(legacy);
+        if (getCellStyle(benchmark) == null) fillWithWideAndCombiningChars(rows);
+
+        long checksum = runPasses(benchmark, rows, 0, WARMUP_PASSES);
+        long start = System.nanoTime();
+        checksum += runPasses(benchmark, rows, WARMUP_PASSES, MEASURED_PASSES);
+        long elapsed = System.nanoTime() - start;
+
+        long memoryUsage = 0;
+        for (Row row : rows)
+            memoryUsage += row.getMemoryUsage();
+
+        long cells = (long) MEASURED_PASSES * ROWS * COLUMNS;
+        System.out.println(String.format(Locale.ROOT,
+            "{\"benchmark\":\"terminal_row_%s\",\"implementation\":\"%s\",\"cells\":%d,\"elapsed_ns\":%d,\"ns_per_cell\":%.2f,\"bytes_per_row\":%d,\"checksum\":%d}",
+            benchmark, legacy ? "legacy" : "palette", cells, elapsed, (double) elapsed / cells, memoryUsage / ROWS, checksum));
+    }
+
+    public static void main(String[] args) {
+        String[] benchmarks = (args.length == 0) ? BENCHMARKS : args;
+        for (String benchmark : benchmarks) {
+            if (!isBenchmark(benchmark)) {
+                System.err.println("TerminalRowBenchmark: unknown benchmark: " + benchmark);
+                System.exit(1);
+            }
+            run(benchmark, true);
+            run(benchmark, false);
+        }
+    }
+
+}
@@ -0,0 +1,386 @@
+/*
+ * Benchmarks for the natives of terminal-emulator (termux.c) and termux-shared (local-socket.cpp), run on a Linux host
+ * through the JNI shim in shim/.
+ *
+ * Each benchmark prints one JSON object per line to stdout, so that results can be collected and compared between
+ * changes. Pass benchmark names as arguments to only run those.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "jni_shim.h"
+
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+
+/* terminal-emulator/src/main/jni/termux.c */
+jint Java_com_termux_terminal_JNI_createSubprocess(JNIEnv* env, jclass clazz, jstring cmd, jstring cwd,
+        jobjectArray args, jobjectArray envVars, jintArray processIdArray, jint rows, jint columns, jint cell_width,
+        jint cell_height);
+void Java_com_termux_terminal_JNI_setPtyWindowSize(JNIEnv* env, jclass clazz, jint fd, jint rows, jint cols,
+        jint cell_width, jint cell_height);
+jint Java_com_termux_terminal_JNI_waitFor(JNIEnv* env, jclass clazz, jint pid);
+void Java_com_termux_terminal_JNI_close(JNIEnv* env, jclass clazz, jint fileDescriptor);
+
+/* termux-shared/src/main/cpp/local-socket.cpp */
+jobject Java_com_termux_shared_net_socket_local_LocalSocketManager_createServerSocketNative(JNIEnv* env, jclass clazz,
+        jstring logTitle, jbyteArray pathArray, jint backlog);
+jobject Java_com_termux_shared_net_socket_local_LocalSocketManager_closeSocketNative(JNIEnv* env, jclass clazz,
+        jstring logTitle, jint fd);
+jobject Java_com_termux_shared_net_socket_local_LocalSocketManager_acceptNative(JNIEnv* env, jclass clazz,
+        jstring logTitle, jint fd);
+jobject Java_com_termux_shared_net_socket_local_LocalSocketManager_readNative(JNIEnv* env, jclass clazz,
+        jstring logTitle, jint fd, jbyteArray dataArray, jlong deadline);
+jobject Java_com_termux_shared_net_socket_local_LocalSocketManager_sendNative(JNIEnv* env, jclass clazz,
+        jstring logTitle, jint fd, jbyteArray dataArray, jlong deadline);
+
+static int64_t now_nanos(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (int64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+static void fail(char const* what, char const* message)
+{
+    fprintf(stderr, "native-benchmarks: %s: %s\n", what, message);
+    exit(1);
+}
+
+static int compare_int64(void const* a, void const* b)
+{
+    int64_t x = *(int64_t const*) a, y = *(int64_t const*) b;
+    return (x > y) - (x < y);
+}
+
+/* Print latency statistics of the samples, which are sorted in place. */
+static void report_latency(char const* name, int64_t* samples, int count)
+{
+    qsort(samples, (size_t) count, sizeof(int64_t), compare_int64);
+    int64_t total = 0;
+    for (int i = 0; i < count; i++) total += samples[i];
+    printf("{\"benchmark\":\"%s\",\"iterations\":%d,\"mean_ns\":%lld,\"min_ns\":%lld,\"p50_ns\":%lld,\"p99_ns\":%lld,\"max_ns\":%lld}\n",
+            name, count, (long long) (total / count), (long long) samples[0], (long long) samples[count / 2],
+            (long long) samples[(count * 99) / 100], (long long) samples[count - 1]);
+    fflush(stdout);
+}
+
+static void report_throughput(char const* name, int64_t bytes, int64_t nanos)
+{
+    printf("{\"benchmark\":\"%s\",\"bytes\":%lld,\"elapsed_ns\":%lld,\"mb_per_s\":%.2f}\n",
+            name, (long long) bytes, (long long) nanos, (bytes / (1024.0 * 1024.0)) / (nanos / 1e9));
+    fflush(stdout);
+}
+
+/* Check the JniResult returned by a local socket native and return its intData. */
+static jint check_jni_result(jobject result, char const* what)
+{
+    if (!result) {
+        char const* exception = jni_shim_take_exception();
+        fail(what, exception ? exception : "no JniResult returned");
+    }
+    if (jni_shim_get_int_field(result, "retval") != 0) {
+        char const* errmsg = jni_shim_string_chars(jni_shim_get_object_field(result, "errmsg"));
+        fail(what, errmsg ? errmsg : "failed");
+    }
+    return jni_shim_get_int_field(result, "intData");
+}
+
+/* Spawn a subprocess through the createSubprocess native, returning the pty master fd. */
+static int spawn(JNIEnv* env, char const* const* argv, int* pid)
+{
+    jobject args[8];
+    int argc = 0;
+    for (; argv[argc]; argc++) args[argc] = jni_shim_new_string(argv[argc]);
+    jobject env_vars[] = { jni_shim_new_string("PATH=/usr/local/bin:/usr/bin:/bin"), jni_shim_new_string("TERM=xterm-256color") };
+    jintArray process_id = jni_shim_new_int_array(1);
+
+    int ptm = Java_com_termux_terminal_JNI_createSubprocess(env, NULL, args[0], jni_shim_new_string("/"),
+            jni_shim_new_object_array(argc, args), jni_shim_new_object_array(ARRAY_SIZE(env_vars), env_vars),
+            process_id, 24, 80, 12, 24);
+    char const* exception = jni_shim_take_exception();
+    if (exception) fail("createSubprocess", exception);
+    *pid = jni_shim_int_array_data(process_id)[0];
+    return ptm;
+}
+
+static void bench_spawn_latency(JNIEnv* env)
+{
+    enum { ITERATIONS = 200 };
+    static int64_t samples[ITERATIONS];
+    char const* const argv[] = { "/bin/true", NULL };
+    for (int i = 0; i < ITERATIONS; i++) {
+        jni_shim_frame frame = jni_shim_local_frame();
+        int pid;
+        int64_t start = now_nanos();
+        int ptm = spawn(env, argv, &pid);
+        samples[i] = now_nanos() - start;
+        Java_com_termux_terminal_JNI_waitFor(env, NULL, pid);
+        Java_com_termux_terminal_JNI_close(env, NULL, ptm);
+        jni_shim_delete_local_refs(frame);
+    }
+    report_latency("spawn_latency", samples, ITERATIONS);
+}
+
+/* Read output of a process writing 64 MiB through the pty, like the TermSessionInputReader thread does. */
+static void bench_pty_read_throughput(JNIEnv* env, char const* name, size_t buffer_size)
+{
+    char const* const argv[] = { "/bin/sh", "-c", "exec head -c 67108864 /dev/zero", NULL };
+    char* buffer = malloc(buffer_size);
+    if (!buffer) fail(name, "malloc() failed");
+
+    jni_shim_frame frame = jni_shim_local_frame();
+    int pid;
+    int64_t start = now_nanos();
+    int ptm = spawn(env, argv, &pid);
+    int64_t bytes = 0;
+    ssize_t bytes_read;
+    // Reading returns -1 with EIO once the process has exited and its output has been drained.
+    while ((bytes_read = read(ptm, buffer, buffer_size)) > 0 || (bytes_read == -1 && errno == EINTR))
+        if (bytes_read > 0) bytes += bytes_read;
+    int64_t elapsed = now_nanos() - start;
+    Java_com_termux_terminal_JNI_waitFor(env, NULL, pid);
+    Java_com_termux_terminal_JNI_close(env, NULL, ptm);
+    jni_shim_delete_local_refs(frame);
+    free(buffer);
+
+    report_throughput(name, bytes, elapsed);
+}
+
+static void bench_pty_read_throughput_4k(JNIEnv* env)
+{
+    bench_pty_read_throughput(env, "pty_read_throughput_4k", 4096);
+}
+
+static void bench_pty_read_throughput_64k(JNIEnv* env)
+{
+    bench_pty_read_throughput(env, "pty_read_throughput_64k", 64 * 1024);
+}
+
+static void bench_pty_winsize_ioctl(JNIEnv* env)
+{
+    enum { ITERATIONS = 100000 };
+    static int64_t samples[ITERATIONS];
+    char const* const argv[] = { "/bin/cat", NULL };
+    jni_shim_frame frame = jni_shim_local_frame();
+    int pid;
+    int ptm = spawn(env, argv, &pid);
+    for (int i = 0; i < ITERATIONS; i++) {
+        int64_t start = now_nanos();
+        // Alternate the size so that every call is an actual change, which signals the process group.
+        Java_com_termux_terminal_JNI_setPtyWindowSize(env, NULL, ptm, 24 + (i & 1), 80, 12, 24);
+        samples[i] = now_nanos() - start;
+    }
+    kill(pid, SIGKILL);
+    Java_com_termux_terminal_JNI_waitFor(env, NULL, pid);
+    Java_com_termux_terminal_JNI_close(env, NULL, ptm);
+    jni_shim_delete_local_refs(frame);
+    report_latency("pty_winsize_ioctl", samples, ITERATIONS);
+}
+
+static char socket_dir[64];
+static char socket_path[108];
+
+/* Create a server socket through the natives and connect a client to it, returning the server fd. */
+static int create_server_socket(JNIEnv* env, jstring title)
+{
+    strcpy(socket_dir, "/tmp/termux-native-benchmarks-XXXXXX");
+    if (!mkdtemp(socket_dir)) fail("mkdtemp", strerror(errno));
+    snprintf(socket_path, sizeof(socket_path), "%s/socket", socket_dir);
+
+    jbyteArray path = jni_shim_new_byte_array((jsize) strlen(socket_path));
+    memcpy(jni_shim_byte_array_data(path), socket_path, strlen(socket_path));
+    return check_jni_result(Java_com_termux_shared_net_socket_local_LocalSocketManager_createServerSocketNative(
+            env, NULL, title, path, 50), "createServerSocketNative");
+}
+
+static void close_server_socket(JNIEnv* env, jstring title, int server_fd)
+{
+    check_jni_result(Java_com_termux_shared_net_socket_local_LocalSocketManager_closeSocketNative(
+            env, NULL, title, server_fd), "closeSocketNative");
+    unlink(socket_path);
+    rmdir(socket_dir);
+}
+
+static int connect_client(void)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) fail("socket", strerror(errno));
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    memcpy(address.sun_path, socket_path, strlen(socket_path) + 1);
+    if (connect(fd, (struct sockaddr*) &address, sizeof(address)) == -1) fail("connect", strerror(errno));
+    return fd;
+}
+
+/* Accept a client through the acceptNative native, returning the client fd on the server side. */
+static int accept_client(JNIEnv* env, jstring title, int server_fd)
+{
+    return check_jni_result(Java_com_termux_shared_net_socket_local_LocalSocketManager_acceptNative(
+            env, NULL, title, server_fd), "acceptNative");
+}
+
+static void bench_local_socket_accept(JNIEnv* env)
+{
+    enum { ITERATIONS = 5000 };
+    static int64_t samples[ITERATIONS];
+    jni_shim_frame frame = jni_shim_local_frame();
+    jstring title = jni_shim_new_string("native-benchmarks");
+    int server_fd = create_server_socket(env, title);
+    for (int i = 0; i < ITERATIONS; i++) {
+        jni_shim_frame iteration_frame = jni_shim_local_frame();
+        int64_t start = now_nanos();
+        int client_fd = connect_client();
+        int accepted_fd = accept_client(env, title, server_fd);
+        samples[i] = now_nanos() - start;
+        check_jni_result(Java_com_termux_shared_net_socket_local_LocalSocketManager_closeSocketNative(
+                env, NULL, title, accepted_fd), "closeSocketNative");
+        close(client_fd);
+        jni_shim_delete_local_refs(iteration_frame);
+    }
+    close_server_socket(env, title, server_fd);
+    jni_shim_delete_local_refs(frame);
+    report_latency("local_socket_accept", samples, ITERATIONS);
+}
+
+struct socket_peer {
+    int fd;
+    int64_t bytes;
+    int chunk_size;
+    int iterations;
+};
+
+/* Send bytes of the peer in chunk_size sendNative calls, then shut down writing. */
+static void* send_thread(void* arg)
+{
+    struct socket_peer* peer = arg;
+    JNIEnv* env = jni_shim_get_env();
+    jstring title = jni_shim_new_string("native-benchmarks-sender");
+    jbyteArray data = jni_shim_new_byte_array(peer->chunk_size);
+    for (int64_t sent = 0; sent < peer->bytes; sent += peer->chunk_size) {
+        jni_shim_frame frame = jni_shim_local_frame();
+        check_jni_result(Java_com_termux_shared_net_socket_local_LocalSocketManager_sendNative(
+                env, NULL, title, peer->fd, data, 0), "sendNative");
+        jni_shim_delete_local_refs(frame);
+    }
+    shutdown(peer->fd, SHUT_WR);
+    jni_shim_delete_local_refs(NULL);
+    return NULL;
+}
+
+static void bench_local_socket_throughput(JNIEnv* env)
+{
+    enum { CHUNK_SIZE = 64 * 1024 };
+    jni_shim_frame frame = jni_shim_local_frame();
+    jstring title = jni_shim_new_string("native-benchmarks");
+    int server_fd = create_server_socket(env, title);
+    struct socket_peer sender = { .fd = connect_client(), .bytes = 256 * 1024 * 1024, .chunk_size = CHUNK_SIZE };
+    int accepted_fd = accept_client(env, title, server_fd);
+    jbyteArray data = jni_shim_new_byte_array(CHUNK_SIZE);
+
+    int64_t start = now_nanos();
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, send_thread, &sender) != 0) fail("pthread_create", "failed");
+    int64_t bytes = 0;
+    while (1) {
+        jni_shim_frame read_frame = jni_shim_local_frame();
+        jint bytes_read = check_jni_result(Java_com_termux_shared_net_socket_local_LocalSocketManager_readNative(
+                env, NULL, title, accepted_fd, data, 0), "readNative");
+        jni_shim_delete_local_refs(read_frame);
+        if (bytes_read == 0) break;
+        bytes += bytes_read;
+    }
+    int64_t elapsed = now_nanos() - start;
+    pthread_join(thread, NULL);
+
+    close(sender.fd);
+    check_jni_result(Java_com_termux_shared_net_socket_local_LocalSocketManager_closeSocketNative(
+            env, NULL, title, accepted_fd), "closeSocketNative");
+    close_server_socket(env, title, server_fd);
+    jni_shim_delete_local_refs(frame);
+    report_throughput("local_socket_throughput", bytes, elapsed);
+}
+
+/* Echo single bytes back to the peer with readNative and sendNative. */
+static void* echo_thread(void* arg)
+{
+    struct socket_peer* peer = arg;
+    JNIEnv* env = jni_shim_get_env();
+    jstring title = jni_shim_new_string("native-benchmarks-echo");
+    jbyteArray data = jni_shim_new_byte_array(1);
+    for (int i = 0; i < peer->iterations; i++) {
+        jni_shim_frame frame = jni_shim_local_frame();
+        check_jni_result(Java_com_termux_shared_net_socket_local_LocalSocketManager_readNative(
+                env, NULL, title, peer->fd, data, 0), "readNative");
+        check_jni_result(Java_com_termux_shared_net_socket_local_LocalSocketManager_sendNative(
+                env, NULL, title, peer->fd, data, 0), "sendNative");
+        jni_shim_delete_local_refs(frame);
+    }
+    jni_shim_delete_local_refs(NULL);
+    return NULL;
+}
+
+static void bench_local_socket_round_trip(JNIEnv* env)
+{
+    enum { ITERATIONS = 20000 };
+    static int64_t samples[ITERATIONS];
+    jni_shim_frame frame = jni_shim_local_frame();
+    jstring title = jni_shim_new_string("native-benchmarks");
+    int server_fd = create_server_socket(env, title);
+    struct socket_peer echo = { .fd = connect_client(), .iterations = ITERATIONS };
+    int accepted_fd = accept_client(env, title, server_fd);
+    jbyteArray data = jni_shim_new_byte_array(1);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, echo_thread, &echo) != 0) fail("pthread_create", "failed");
+    for (int i = 0; i < ITERATIONS; i++) {
+        jni_shim_frame iteration_frame = jni_shim_local_frame();
+        int64_t start = now_nanos();
+        check_jni_result(Java_com_termux_shared_net_socket_local_LocalSocketManager_sendNative(
+                env, NULL, title, accepted_fd, data, 0), "sendNative");
+        check_jni_result(Java_com_termux_shared_net_socket_local_LocalSocketManager_readNative(
+                env, NULL, title, accepted_fd, data, 0), "readNative");
+        samples[i] = now_nanos() - start;
+        jni_shim_delete_local_refs(iteration_frame);
+    }
+    pthread_join(thread, NULL);
+
+    close(echo.fd);
+    check_jni_result(Java_com_termux_shared_net_socket_local_LocalSocketManager_closeSocketNative(
+            env, NULL, title, accepted_fd), "closeSocketNative");
+    close_server_socket(env, title, server_fd);
+    jni_shim_delete_local_refs(frame);
+    report_latency("local_socket_round_trip", samples, ITERATIONS);
+}
+
+static struct {
+    char const* name;
+    void (*run)(JNIEnv* env);
+} const benchmarks[] = {
+    { "spawn_latency", bench_spawn_latency },
+    { "pty_read_throughput_4k", bench_pty_read_throughput_4k },
+    { "pty_read_throughput_64k", bench_pty_read_throughput_64k },
+    { "pty_winsize_ioctl", bench_pty_winsize_ioctl },
+    { "local_socket_accept", bench_local_socket_accept },
+    { "local_socket_throughput", bench_local_socket_throughput },
+    { "local_socket_round_trip", bench_local_socket_round_trip },
+};
+
+int main(int argc, char** argv)
+{
+    JNIEnv* env = jni_shim_get_env();
+    for (size_t i = 0; i < ARRAY_SIZE(benchmarks); i++) {
+        int selected = argc < 2;
+        for (int j = 1; j < argc; j++)
+            if (strcmp(argv[j], benchmarks[i].name) == 0) selected = 1;
+        if (selected) benchmarks[i].run(env);
+    }
+    return 0;
+}
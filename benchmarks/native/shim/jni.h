@@ -0,0 +1,119 @@
+/*
+ * Minimal stand-in for the JNI header, so that the natives of termux can be built and benchmarked on a plain Linux
+ * host without a JVM. Only the types and functions used by the natives are declared. The functions are implemented
+ * by jni_shim.c on top of a tiny object model, see jni_shim.h.
+ */
+#ifndef TERMUX_JNI_SHIM_JNI_H
+#define TERMUX_JNI_SHIM_JNI_H
+
+#include <stdarg.h>
+#include <stdint.h>
+
+typedef uint8_t jboolean;
+typedef int8_t jbyte;
+typedef uint16_t jchar;
+typedef int16_t jshort;
+typedef int32_t jint;
+typedef int64_t jlong;
+typedef float jfloat;
+typedef double jdouble;
+typedef jint jsize;
+
+typedef struct _jobject* jobject;
+typedef jobject jclass;
+typedef jobject jstring;
+typedef jobject jthrowable;
+typedef jobject jarray;
+typedef jarray jobjectArray;
+typedef jarray jbyteArray;
+typedef jarray jintArray;
+
+typedef struct _jfieldID* jfieldID;
+typedef struct _jmethodID* jmethodID;
+
+#define JNI_FALSE 0
+#define JNI_TRUE 1
+
+#define JNI_OK 0
+#define JNI_COMMIT 1
+#define JNI_ABORT 2
+
+#define JNIEXPORT __attribute__((visibility("default")))
+#define JNICALL
+
+struct JNINativeInterface;
+
+#ifdef __cplusplus
+struct _JNIEnv;
+typedef _JNIEnv JNIEnv;
+#else
+typedef const struct JNINativeInterface* JNIEnv;
+#endif
+
+struct JNINativeInterface {
+    jclass (*FindClass)(JNIEnv*, const char*);
+    jint (*Throw)(JNIEnv*, jthrowable);
+    jint (*ThrowNew)(JNIEnv*, jclass, const char*);
+    jthrowable (*ExceptionOccurred)(JNIEnv*);
+    void (*ExceptionClear)(JNIEnv*);
+    jboolean (*ExceptionCheck)(JNIEnv*);
+    jobject (*NewObjectV)(JNIEnv*, jclass, jmethodID, va_list);
+    jclass (*GetObjectClass)(JNIEnv*, jobject);
+    jmethodID (*GetMethodID)(JNIEnv*, jclass, const char*, const char*);
+    jobject (*CallObjectMethodV)(JNIEnv*, jobject, jmethodID, va_list);
+    jfieldID (*GetFieldID)(JNIEnv*, jclass, const char*, const char*);
+    void (*SetObjectField)(JNIEnv*, jobject, jfieldID, jobject);
+    void (*SetIntField)(JNIEnv*, jobject, jfieldID, jint);
+    jstring (*NewStringUTF)(JNIEnv*, const char*);
+    const char* (*GetStringUTFChars)(JNIEnv*, jstring, jboolean*);
+    void (*ReleaseStringUTFChars)(JNIEnv*, jstring, const char*);
+    jsize (*GetArrayLength)(JNIEnv*, jarray);
+    jobject (*GetObjectArrayElement)(JNIEnv*, jobjectArray, jsize);
+    jbyte* (*GetByteArrayElements)(JNIEnv*, jbyteArray, jboolean*);
+    void (*ReleaseByteArrayElements)(JNIEnv*, jbyteArray, jbyte*, jint);
+    void* (*GetPrimitiveArrayCritical)(JNIEnv*, jarray, jboolean*);
+    void (*ReleasePrimitiveArrayCritical)(JNIEnv*, jarray, void*, jint);
+};
+
+#ifdef __cplusplus
+struct _JNIEnv {
+    const struct JNINativeInterface* functions;
+
+    jclass FindClass(const char* name) { return functions->FindClass(this, name); }
+    jint Throw(jthrowable obj) { return functions->Throw(this, obj); }
+    jint ThrowNew(jclass clazz, const char* message) { return functions->ThrowNew(this, clazz, message); }
+    jthrowable ExceptionOccurred() { return functions->ExceptionOccurred(this); }
+    void ExceptionClear() { functions->ExceptionClear(this); }
+    jboolean ExceptionCheck() { return functions->ExceptionCheck(this); }
+    jobject NewObject(jclass clazz, jmethodID methodID, ...) {
+        va_list args;
+        va_start(args, methodID);
+        jobject result = functions->NewObjectV(this, clazz, methodID, args);
+        va_end(args);
+        return result;
+    }
+    jclass GetObjectClass(jobject obj) { return functions->GetObjectClass(this, obj); }
+    jmethodID GetMethodID(jclass clazz, const char* name, const char* sig) { return functions->GetMethodID(this, clazz, name, sig); }
+    jobject CallObjectMethod(jobject obj, jmethodID methodID, ...) {
+        va_list args;
+        va_start(args, methodID);
+        jobject result = functions->CallObjectMethodV(this, obj, methodID, args);
+        va_end(args);
+        return result;
+    }
+    jfieldID GetFieldID(jclass clazz, const char* name, const char* sig) { return functions->GetFieldID(this, clazz, name, sig); }
+    void SetObjectField(jobject obj, jfieldID fieldID, jobject value) { functions->SetObjectField(this, obj, fieldID, value); }
+    void SetIntField(jobject obj, jfieldID fieldID, jint value) { functions->SetIntField(this, obj, fieldID, value); }
+    jstring NewStringUTF(const char* bytes) { return functions->NewStringUTF(this, bytes); }
+    const char* GetStringUTFChars(jstring string, jboolean* isCopy) { return functions->GetStringUTFChars(this, string, isCopy); }
+    void ReleaseStringUTFChars(jstring string, const char* utf) { functions->ReleaseStringUTFChars(this, string, utf); }
+    jsize GetArrayLength(jarray array) { return functions->GetArrayLength(this, array); }
+    jobject GetObjectArrayElement(jobjectArray array, jsize index) { return functions->GetObjectArrayElement(this, array, index); }
+    jbyte* GetByteArrayElements(jbyteArray array, jboolean* isCopy) { return functions->GetByteArrayElements(this, array, isCopy); }
+    void ReleaseByteArrayElements(jbyteArray array, jbyte* elems, jint mode) { functions->ReleaseByteArrayElements(this, array, elems, mode); }
+    void* GetPrimitiveArrayCritical(jarray array, jboolean* isCopy) { return functions->GetPrimitiveArrayCritical(this, array, isCopy); }
+    void ReleasePrimitiveArrayCritical(jarray array, void* carray, jint mode) { functions->ReleasePrimitiveArrayCritical(this, array, carray, mode); }
+};
+#endif
+
+#endif
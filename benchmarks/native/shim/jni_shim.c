@@ -0,0 +1,363 @@
+/*
+ * Implementation of the JNI shim declared in jni.h and jni_shim.h.
+ *
+ * Objects are tagged heap allocations linked into a per-thread list of local references. Classes and methods are
+ * identified only by name, which is enough for the String, Class and JniResult usage of the natives.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <android/log.h>
+
+#include "jni_shim.h"
+
+#define JNI_SHIM_MAX_FIELDS 8
+
+enum jni_shim_object_type {
+    JNI_SHIM_CLASS,
+    JNI_SHIM_STRING,
+    JNI_SHIM_BYTE_ARRAY,
+    JNI_SHIM_INT_ARRAY,
+    JNI_SHIM_OBJECT_ARRAY,
+    JNI_SHIM_OBJECT,
+};
+
+struct jni_shim_field {
+    const char* name;
+    jint int_value;
+    jobject object_value;
+};
+
+struct _jobject {
+    enum jni_shim_object_type type;
+    struct _jobject* next_local_ref;
+    /* The class name for JNI_SHIM_CLASS and JNI_SHIM_OBJECT, the chars for JNI_SHIM_STRING. */
+    char* name;
+    jsize length;
+    void* elements;
+    struct jni_shim_field fields[JNI_SHIM_MAX_FIELDS];
+    int field_count;
+};
+
+/* Field and method ids point into the method_ids and field_ids tables below. */
+struct _jfieldID { const char* name; };
+struct _jmethodID { const char* name; };
+
+static _Thread_local struct _jobject* local_refs;
+static _Thread_local char* pending_exception;
+static _Thread_local char* taken_exception;
+
+static jobject new_object(enum jni_shim_object_type type, const char* name, jsize length, size_t element_size)
+{
+    struct _jobject* obj = calloc(1, sizeof(struct _jobject));
+    if (!obj) abort();
+    obj->type = type;
+    obj->name = name ? strdup(name) : NULL;
+    obj->length = length;
+    if (element_size > 0) {
+        obj->elements = calloc((size_t) (length > 0 ? length : 1), element_size);
+        if (!obj->elements) abort();
+    }
+    obj->next_local_ref = local_refs;
+    local_refs = obj;
+    return obj;
+}
+
+static struct jni_shim_field* find_field(jobject obj, const char* name, int create)
+{
+    for (int i = 0; i < obj->field_count; i++)
+        if (strcmp(obj->fields[i].name, name) == 0) return &obj->fields[i];
+    if (!create || obj->field_count == JNI_SHIM_MAX_FIELDS) return NULL;
+    struct jni_shim_field* field = &obj->fields[obj->field_count++];
+    field->name = name;
+    return field;
+}
+
+/* The methods and fields known by the shim, which is what the natives look up. */
+static struct _jmethodID method_ids[] = { {"<init>"}, {"getBytes"}, {"getName"} };
+static struct _jfieldID field_ids[] = { {"retval"}, {"errno"}, {"errmsg"}, {"intData"}, {"pid"}, {"uid"}, {"gid"},
+    {"pname"}, {"cmdline"} };
+
+static jclass shim_FindClass(JNIEnv* env, const char* name)
+{
+    (void) env;
+    return new_object(JNI_SHIM_CLASS, name, 0, 0);
+}
+
+static jint shim_Throw(JNIEnv* env, jthrowable obj)
+{
+    (void) env;
+    free(pending_exception);
+    pending_exception = strdup(obj && obj->name ? obj->name : "java/lang/Throwable");
+    return JNI_OK;
+}
+
+static jint shim_ThrowNew(JNIEnv* env, jclass clazz, const char* message)
+{
+    (void) env;
+    free(pending_exception);
+    size_t length = strlen(clazz->name) + strlen(message) + 3;
+    pending_exception = malloc(length);
+    if (!pending_exception) abort();
+    snprintf(pending_exception, length, "%s: %s", clazz->name, message);
+    return JNI_OK;
+}
+
+static jthrowable shim_ExceptionOccurred(JNIEnv* env)
+{
+    (void) env;
+    return pending_exception ? new_object(JNI_SHIM_OBJECT, pending_exception, 0, 0) : NULL;
+}
+
+static void shim_ExceptionClear(JNIEnv* env)
+{
+    (void) env;
+    free(pending_exception);
+    pending_exception = NULL;
+}
+
+static jboolean shim_ExceptionCheck(JNIEnv* env)
+{
+    (void) env;
+    return pending_exception != NULL;
+}
+
+static jobject shim_NewObjectV(JNIEnv* env, jclass clazz, jmethodID method_id, va_list args)
+{
+    (void) env;
+    jobject obj = new_object(JNI_SHIM_OBJECT, clazz->name, 0, 0);
+    if (strcmp(clazz->name, "com/termux/shared/jni/models/JniResult") == 0 && strcmp(method_id->name, "<init>") == 0) {
+        find_field(obj, "retval", 1)->int_value = va_arg(args, jint);
+        find_field(obj, "errno", 1)->int_value = va_arg(args, jint);
+        find_field(obj, "errmsg", 1)->object_value = va_arg(args, jobject);
+        find_field(obj, "intData", 1)->int_value = va_arg(args, jint);
+    }
+    return obj;
+}
+
+static jclass shim_GetObjectClass(JNIEnv* env, jobject obj)
+{
+    (void) env;
+    return new_object(JNI_SHIM_CLASS, obj->type == JNI_SHIM_STRING ? "java/lang/String" : obj->name, 0, 0);
+}
+
+static jmethodID shim_GetMethodID(JNIEnv* env, jclass clazz, const char* name, const char* sig)
+{
+    (void) env; (void) clazz; (void) sig;
+    for (size_t i = 0; i < sizeof(method_ids) / sizeof(method_ids[0]); i++)
+        if (strcmp(method_ids[i].name, name) == 0) return &method_ids[i];
+    return NULL;
+}
+
+static jobject shim_CallObjectMethodV(JNIEnv* env, jobject obj, jmethodID method_id, va_list args)
+{
+    (void) env; (void) args;
+    if (strcmp(method_id->name, "getBytes") == 0 && obj->type == JNI_SHIM_STRING) {
+        jsize length = (jsize) strlen(obj->name);
+        jbyteArray bytes = new_object(JNI_SHIM_BYTE_ARRAY, NULL, length, sizeof(jbyte));
+        memcpy(bytes->elements, obj->name, (size_t) length);
+        return bytes;
+    } else if (strcmp(method_id->name, "getName") == 0 && obj->type == JNI_SHIM_CLASS) {
+        return new_object(JNI_SHIM_STRING, obj->name, 0, 0);
+    }
+    return NULL;
+}
+
+static jfieldID shim_GetFieldID(JNIEnv* env, jclass clazz, const char* name, const char* sig)
+{
+    (void) env; (void) clazz; (void) sig;
+    for (size_t i = 0; i < sizeof(field_ids) / sizeof(field_ids[0]); i++)
+        if (strcmp(field_ids[i].name, name) == 0) return &field_ids[i];
+    return NULL;
+}
+
+static void shim_SetObjectField(JNIEnv* env, jobject obj, jfieldID field_id, jobject value)
+{
+    (void) env;
+    struct jni_shim_field* field = find_field(obj, field_id->name, 1);
+    if (field) field->object_value = value;
+}
+
+static void shim_SetIntField(JNIEnv* env, jobject obj, jfieldID field_id, jint value)
+{
+    (void) env;
+    struct jni_shim_field* field = find_field(obj, field_id->name, 1);
+    if (field) field->int_value = value;
+}
+
+static jstring shim_NewStringUTF(JNIEnv* env, const char* bytes)
+{
+    (void) env;
+    return new_object(JNI_SHIM_STRING, bytes, 0, 0);
+}
+
+static const char* shim_GetStringUTFChars(JNIEnv* env, jstring string, jboolean* is_copy)
+{
+    (void) env;
+    if (is_copy) *is_copy = JNI_FALSE;
+    return string->name;
+}
+
+static void shim_ReleaseStringUTFChars(JNIEnv* env, jstring string, const char* utf)
+{
+    (void) env; (void) string; (void) utf;
+}
+
+static jsize shim_GetArrayLength(JNIEnv* env, jarray array)
+{
+    (void) env;
+    return array->length;
+}
+
+static jobject shim_GetObjectArrayElement(JNIEnv* env, jobjectArray array, jsize index)
+{
+    (void) env;
+    return ((jobject*) array->elements)[index];
+}
+
+static jbyte* shim_GetByteArrayElements(JNIEnv* env, jbyteArray array, jboolean* is_copy)
+{
+    (void) env;
+    if (is_copy) *is_copy = JNI_FALSE;
+    return array->elements;
+}
+
+static void shim_ReleaseByteArrayElements(JNIEnv* env, jbyteArray array, jbyte* elems, jint mode)
+{
+    (void) env; (void) array; (void) elems; (void) mode;
+}
+
+static void* shim_GetPrimitiveArrayCritical(JNIEnv* env, jarray array, jboolean* is_copy)
+{
+    (void) env;
+    if (is_copy) *is_copy = JNI_FALSE;
+    return array->elements;
+}
+
+static void shim_ReleasePrimitiveArrayCritical(JNIEnv* env, jarray array, void* carray, jint mode)
+{
+    (void) env; (void) array; (void) carray; (void) mode;
+}
+
+static const struct JNINativeInterface native_interface = {
+    .FindClass = shim_FindClass,
+    .Throw = shim_Throw,
+    .ThrowNew = shim_ThrowNew,
+    .ExceptionOccurred = shim_ExceptionOccurred,
+    .ExceptionClear = shim_ExceptionClear,
+    .ExceptionCheck = shim_ExceptionCheck,
+    .NewObjectV = shim_NewObjectV,
+    .GetObjectClass = shim_GetObjectClass,
+    .GetMethodID = shim_GetMethodID,
+    .CallObjectMethodV = shim_CallObjectMethodV,
+    .GetFieldID = shim_GetFieldID,
+    .SetObjectField = shim_SetObjectField,
+    .SetIntField = shim_SetIntField,
+    .NewStringUTF = shim_NewStringUTF,
+    .GetStringUTFChars = shim_GetStringUTFChars,
+    .ReleaseStringUTFChars = shim_ReleaseStringUTFChars,
+    .GetArrayLength = shim_GetArrayLength,
+    .GetObjectArrayElement = shim_GetObjectArrayElement,
+    .GetByteArrayElements = shim_GetByteArrayElements,
+    .ReleaseByteArrayElements = shim_ReleaseByteArrayElements,
+    .GetPrimitiveArrayCritical = shim_GetPrimitiveArrayCritical,
+    .ReleasePrimitiveArrayCritical = shim_ReleasePrimitiveArrayCritical,
+};
+
+static JNIEnv env_instance = &native_interface;
+
+JNIEnv* jni_shim_get_env(void)
+{
+    return &env_instance;
+}
+
+jstring jni_shim_new_string(const char* utf8)
+{
+    return new_object(JNI_SHIM_STRING, utf8, 0, 0);
+}
+
+jbyteArray jni_shim_new_byte_array(jsize length)
+{
+    return new_object(JNI_SHIM_BYTE_ARRAY, NULL, length, sizeof(jbyte));
+}
+
+jbyte* jni_shim_byte_array_data(jbyteArray array)
+{
+    return array->elements;
+}
+
+jintArray jni_shim_new_int_array(jsize length)
+{
+    return new_object(JNI_SHIM_INT_ARRAY, NULL, length, sizeof(jint));
+}
+
+jint* jni_shim_int_array_data(jintArray array)
+{
+    return array->elements;
+}
+
+jobjectArray jni_shim_new_object_array(jsize length, const jobject* elements)
+{
+    jobjectArray array = new_object(JNI_SHIM_OBJECT_ARRAY, NULL, length, sizeof(jobject));
+    if (length > 0) memcpy(array->elements, elements, (size_t) length * sizeof(jobject));
+    return array;
+}
+
+jint jni_shim_get_int_field(jobject obj, const char* name)
+{
+    struct jni_shim_field* field = find_field(obj, name, 0);
+    return field ? field->int_value : 0;
+}
+
+jobject jni_shim_get_object_field(jobject obj, const char* name)
+{
+    struct jni_shim_field* field = find_field(obj, name, 0);
+    return field ? field->object_value : NULL;
+}
+
+const char* jni_shim_string_chars(jstring string)
+{
+    return string ? string->name : NULL;
+}
+
+const char* jni_shim_take_exception(void)
+{
+    free(taken_exception);
+    taken_exception = pending_exception;
+    pending_exception = NULL;
+    return taken_exception;
+}
+
+jni_shim_frame jni_shim_local_frame(void)
+{
+    return local_refs;
+}
+
+void jni_shim_delete_local_refs(jni_shim_frame frame)
+{
+    while (local_refs && local_refs != frame) {
+        struct _jobject* obj = local_refs;
+        local_refs = obj->next_local_ref;
+        free(obj->name);
+        free(obj->elements);
+        free(obj);
+    }
+}
+
+int __android_log_write(int prio, const char* tag, const char* text)
+{
+    return fprintf(stderr, "%d/%s: %s\n", prio, tag, text);
+}
+
+int __android_log_print(int prio, const char* tag, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int result = fprintf(stderr, "%d/%s: ", prio, tag);
+    result += vfprintf(stderr, fmt, args);
+    result += fprintf(stderr, "\n");
+    va_end(args);
+    return result;
+}
@@ -0,0 +1,45 @@
+/*
+ * Host side helpers of the JNI shim, used by the benchmarks to create the arguments passed to the natives and to
+ * inspect their results.
+ *
+ * All objects are "local references" of the calling thread. They stay valid until they are freed by a call to
+ * jni_shim_delete_local_refs() from that thread with a frame taken before they were created.
+ */
+#ifndef TERMUX_JNI_SHIM_H
+#define TERMUX_JNI_SHIM_H
+
+#include <jni.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+JNIEnv* jni_shim_get_env(void);
+
+jstring jni_shim_new_string(const char* utf8);
+jbyteArray jni_shim_new_byte_array(jsize length);
+jbyte* jni_shim_byte_array_data(jbyteArray array);
+jintArray jni_shim_new_int_array(jsize length);
+jint* jni_shim_int_array_data(jintArray array);
+jobjectArray jni_shim_new_object_array(jsize length, const jobject* elements);
+
+/* Get an int or object field of an object created by the natives, like the "intData" of a JniResult. */
+jint jni_shim_get_int_field(jobject obj, const char* name);
+jobject jni_shim_get_object_field(jobject obj, const char* name);
+const char* jni_shim_string_chars(jstring string);
+
+/* Get the message of the pending exception and clear it, or NULL if there is none. */
+const char* jni_shim_take_exception(void);
+
+typedef struct _jobject* jni_shim_frame;
+
+/* Get the current local reference frame of the calling thread, NULL if no objects have been created. */
+jni_shim_frame jni_shim_local_frame(void);
+/* Free all objects of the calling thread created after frame was taken, or all objects if frame is NULL. */
+void jni_shim_delete_local_refs(jni_shim_frame frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
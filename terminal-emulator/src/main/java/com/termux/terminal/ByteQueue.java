@@ -17,6 +17,10 @@ final class ByteQueue {
         notify();
     }
 
+    public synchronized boolean isEmpty() {
+        return mStoredBytes == 0;
+    }
+
     public synchronized int read(byte[] buffer, boolean block) {
         while (mStoredBytes == 0 && mOpen) {
             if (block) {
@@ -51,6 +55,45 @@ final class ByteQueue {
         return totalRead;
     }
 
+    /**
+     * Write as much of the specified portion of the provided buffer as fits in the queue without waiting for the
+     * reader, so that large writes (like pastes) do not block the calling thread. The caller has to keep the rest and
+     * write it again once the reader has drained the queue.
+     * <p/>
+     * Returns the number of bytes written, which may be less than the length or 0 if the queue is full, or -1 if it was
+     * closed before.
+     */
+    public synchronized int writeWithoutBlocking(byte[] buffer, int offset, int lengthToWrite) {
+        if (lengthToWrite + offset > buffer.length) {
+            throw new IllegalArgumentException("length + offset > buffer.length");
+        } else if (lengthToWrite <= 0) {
+            throw new IllegalArgumentException("length <= 0");
+        }
+        if (!mOpen) return -1;
+
+        final boolean wasEmpty = mStoredBytes == 0;
+        final int bufferLength = mBuffer.length;
+        int bytesWritten = 0;
+        while (lengthToWrite > 0 && mStoredBytes < bufferLength) {
+            int tail = mHead + mStoredBytes;
+            int oneRun;
+            if (tail >= bufferLength) {
+                tail = tail - bufferLength;
+                oneRun = mHead - tail;
+            } else {
+                oneRun = bufferLength - tail;
+            }
+            int bytesToCopy = Math.min(oneRun, lengthToWrite);
+            System.arraycopy(buffer, offset, mBuffer, tail, bytesToCopy);
+            offset += bytesToCopy;
+            lengthToWrite -= bytesToCopy;
+            mStoredBytes += bytesToCopy;
+            bytesWritten += bytesToCopy;
+        }
+        if (wasEmpty && bytesWritten > 0) notify();
+        return bytesWritten;
+    }
+
     /**
      * Attempt to write the specified portion of the provided buffer to the queue.
      * <p/>
@@ -0,0 +1,70 @@
+package com.termux.terminal;
+
+/**
+ * The frame accounting deciding when a {@link TerminalSession} enters and leaves flood mode, kept apart from its
+ * Handler so that it can be tested without a Looper. Times are {@link android.os.SystemClock#uptimeMillis()}.
+ * <p>
+ * Flood mode is entered when more than {@link #BYTES_PER_FRAME_THRESHOLD} bytes are processed within one frame of
+ * {@link #FRAME_INTERVAL_MILLIS}, and left at the end of a frame where neither it nor the frame before it exceeded the
+ * threshold.
+ */
+final class FloodModeDetector {
+
+    /** The interval at which the screen is refreshed while in flood mode, roughly one display frame. */
+    static final int FRAME_INTERVAL_MILLIS = 16;
+    /**
+     * The number of bytes processed within one {@link #FRAME_INTERVAL_MILLIS} above which flood mode is entered.
+     * Interactive programs stay well below this, while e.g. `cat` of a large file exceeds it on every frame.
+     */
+    static final int BYTES_PER_FRAME_THRESHOLD = 128 * 1024;
+
+    private boolean mFloodMode;
+    /** The time at which the current frame started. */
+    private long mFrameStartTime;
+    /** The number of bytes processed in the current frame. */
+    private int mBytesInFrame;
+    /** The number of bytes processed in the previous frame, or 0 if it did not immediately precede the current. */
+    private int mBytesInPreviousFrame;
+
+    boolean isFloodMode() {
+        return mFloodMode;
+    }
+
+    /** The time at which the current frame ends, and the next flood mode screen update is due. */
+    long getFrameEndTime() {
+        return mFrameStartTime + FRAME_INTERVAL_MILLIS;
+    }
+
+    /** Account for bytes processed at the given time, returning whether flood mode is active. */
+    boolean onBytesProcessed(long now, int bytes) {
+        updateFrame(now);
+        mBytesInFrame += bytes;
+        if (mBytesInFrame > BYTES_PER_FRAME_THRESHOLD) mFloodMode = true;
+        return mFloodMode;
+    }
+
+    /** Called when a flood mode frame has been published, returning whether flood mode is still active. */
+    boolean onFrame(long now) {
+        updateFrame(now);
+        if (mBytesInPreviousFrame <= BYTES_PER_FRAME_THRESHOLD && mBytesInFrame <= BYTES_PER_FRAME_THRESHOLD)
+            mFloodMode = false;
+        return mFloodMode;
+    }
+
+    /** Leave flood mode and forget the processed bytes, like when the process has exited. */
+    void reset() {
+        mFloodMode = false;
+        mBytesInFrame = 0;
+        mBytesInPreviousFrame = 0;
+    }
+
+    /** Start a new frame if the current one has ended. */
+    private void updateFrame(long now) {
+        long elapsed = now - mFrameStartTime;
+        if (elapsed < FRAME_INTERVAL_MILLIS) return;
+        mBytesInPreviousFrame = (elapsed < 2 * FRAME_INTERVAL_MILLIS) ? mBytesInFrame : 0;
+        mFrameStartTime = now;
+        mBytesInFrame = 0;
+    }
+
+}
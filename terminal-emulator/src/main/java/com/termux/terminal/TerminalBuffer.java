@@ -59,50 +59,57 @@ public final class TerminalBuffer {
 
     public String getSelectedText(int selX1, int selY1, int selX2, int selY2, boolean joinBackLines, boolean joinFullLines) {
         final StringBuilder builder = new StringBuilder();
-        final int columns = mColumns;
 
         if (selY1 < -getActiveTranscriptRows()) selY1 = -getActiveTranscriptRows();
         if (selY2 >= mScreenRows) selY2 = mScreenRows - 1;
 
-        for (int row = selY1; row <= selY2; row++) {
-            int x1 = (row == selY1) ? selX1 : 0;
-            int x2;
-            if (row == selY2) {
-                x2 = selX2 + 1;
-                if (x2 > columns) x2 = columns;
-            } else {
-                x2 = columns;
-            }
-            TerminalRow lineObject = mLines[externalToInternalRow(row)];
-            int x1Index = lineObject.findStartOfColumn(x1);
-            int x2Index = (x2 < mColumns) ? lineObject.findStartOfColumn(x2) : lineObject.getSpaceUsed();
-            if (x2Index == x1Index) {
-                // Selected the start of a wide character.
-                x2Index = lineObject.findStartOfColumn(x2 + 1);
-            }
-            char[] line = lineObject.mText;
-            int lastPrintingCharIndex = -1;
-            int i;
-            boolean rowLineWrap = getLineWrap(row);
-            if (rowLineWrap && x2 == columns) {
-                // If the line was wrapped, we shouldn't lose trailing space:
-                lastPrintingCharIndex = x2Index - 1;
-            } else {
-                for (i = x1Index; i < x2Index; ++i) {
-                    char c = line[i];
-                    if (c != ' ') lastPrintingCharIndex = i;
-                }
+        for (int row = selY1; row <= selY2; row++)
+            appendSelectedRowText(builder, mLines[externalToInternalRow(row)], row, selX1, selY1, selX2, selY2, mColumns,
+                mScreenRows, joinBackLines, joinFullLines);
+        return builder.toString();
+    }
+
+    /**
+     * Append the selected text of a row to a builder, followed by a newline if the row is not joined with the next
+     * one. Shared by {@link #getSelectedText(int, int, int, int, boolean, boolean)} and {@link TerminalBufferSnapshot}.
+     */
+    static void appendSelectedRowText(StringBuilder builder, TerminalRow lineObject, int row, int selX1, int selY1, int selX2,
+                                      int selY2, int columns, int screenRows, boolean joinBackLines, boolean joinFullLines) {
+        int x1 = (row == selY1) ? selX1 : 0;
+        int x2;
+        if (row == selY2) {
+            x2 = selX2 + 1;
+            if (x2 > columns) x2 = columns;
+        } else {
+            x2 = columns;
+        }
+        int x1Index = lineObject.findStartOfColumn(x1);
+        int x2Index = (x2 < columns) ? lineObject.findStartOfColumn(x2) : lineObject.getSpaceUsed();
+        if (x2Index == x1Index) {
+            // Selected the start of a wide character.
+            x2Index = lineObject.findStartOfColumn(x2 + 1);
+        }
+        char[] line = lineObject.mText;
+        int lastPrintingCharIndex = -1;
+        int i;
+        boolean rowLineWrap = lineObject.mLineWrap;
+        if (rowLineWrap && x2 == columns) {
+            // If the line was wrapped, we shouldn't lose trailing space:
+            lastPrintingCharIndex = x2Index - 1;
+        } else {
+            for (i = x1Index; i < x2Index; ++i) {
+                char c = line[i];
+                if (c != ' ') lastPrintingCharIndex = i;
             }
+        }
 
-            int len = lastPrintingCharIndex - x1Index + 1;
-            if (lastPrintingCharIndex != -1 && len > 0)
-                builder.append(line, x1Index, len);
+        int len = lastPrintingCharIndex - x1Index + 1;
+        if (lastPrintingCharIndex != -1 && len > 0)
+            builder.append(line, x1Index, len);
 
-            boolean lineFillsWidth = lastPrintingCharIndex == x2Index - 1;
-            if ((!joinBackLines || !rowLineWrap) && (!joinFullLines || !lineFillsWidth)
-                && row < selY2 && row < mScreenRows - 1) builder.append('\n');
-        }
-        return builder.toString();
+        boolean lineFillsWidth = lastPrintingCharIndex == x2Index - 1;
+        if ((!joinBackLines || !rowLineWrap) && (!joinFullLines || !lineFillsWidth)
+            && row < selY2 && row < screenRows - 1) builder.append('\n');
     }
 
     public String getWordAtLocation(int x, int y) {
@@ -152,6 +159,41 @@ public final class TerminalBuffer {
         return mActiveTranscriptRows + mScreenRows;
     }
 
+    /** The length of the circular buffer, that is, the screen rows plus the maximum number of transcript rows. */
+    public int getTotalRows() {
+        return mTotalRows;
+    }
+
+    /** Approximate number of heap bytes retained by the allocated rows of this buffer. */
+    public long getMemoryUsage() {
+        long bytes = 0;
+        for (TerminalRow row : mLines)
+            if (row != null) bytes += row.getMemoryUsage();
+        return bytes;
+    }
+
+    /**
+     * Change the length of the circular buffer without touching the screen. If shrinking, the oldest transcript rows
+     * that no longer fit are released. Unlike {@link #resize}, this never reflows or allocates rows.
+     *
+     * @param newTotalRows The new length of the buffer, which must be at least the number of screen rows.
+     */
+    public void setTotalRows(int newTotalRows) {
+        if (newTotalRows < mScreenRows)
+            throw new IllegalArgumentException("newTotalRows=" + newTotalRows + ", mScreenRows=" + mScreenRows);
+        if (newTotalRows == mTotalRows) return;
+
+        final int keptTranscriptRows = Math.min(mActiveTranscriptRows, newTotalRows - mScreenRows);
+        TerminalRow[] newLines = new TerminalRow[newTotalRows];
+        for (int i = 0; i < keptTranscriptRows + mScreenRows; i++)
+            newLines[i] = mLines[externalToInternalRow(i - keptTranscriptRows)];
+
+        mLines = newLines;
+        mTotalRows = newTotalRows;
+        mActiveTranscriptRows = keptTranscriptRows;
+        mScreenFirstRow = keptTranscriptRows;
+    }
+
     /**
      * Convert a row value from the public external coordinate system to our internal private coordinate system.
      *
@@ -181,7 +223,8 @@ public final class TerminalBuffer {
     }
 
     public void setLineWrap(int row) {
-        mLines[externalToInternalRow(row)].mLineWrap = true;
+        final int internalRow = externalToInternalRow(row);
+        if (!mLines[internalRow].mLineWrap) getRowForWriting(internalRow).mLineWrap = true;
     }
 
     public boolean getLineWrap(int row) {
@@ -189,7 +232,31 @@ public final class TerminalBuffer {
     }
 
     public void clearLineWrap(int row) {
-        mLines[externalToInternalRow(row)].mLineWrap = false;
+        final int internalRow = externalToInternalRow(row);
+        if (mLines[internalRow].mLineWrap) getRowForWriting(internalRow).mLineWrap = false;
+    }
+
+    /**
+     * Create an immutable snapshot of the transcript and screen, which can be read from any thread while the emulator
+     * keeps modifying this buffer. The rows are shared with the snapshot and this buffer replaces a shared row with a
+     * copy before modifying it, so creating a snapshot mostly costs copying the row references. Must be called on the
+     * thread modifying this buffer.
+     */
+    public TerminalBufferSnapshot createSnapshot() {
+        final int activeRows = getActiveRows();
+        final TerminalRow[] rows = new TerminalRow[activeRows];
+        for (int i = 0; i < activeRows; i++) {
+            TerminalRow row = allocateFullLineIfNecessary(externalToInternalRow(i - mActiveTranscriptRows));
+            row.setSharedWithSnapshot();
+            rows[i] = row;
+        }
+        return new TerminalBufferSnapshot(rows, mColumns, mScreenRows, mActiveTranscriptRows);
+    }
+
+    /** Get a row for modification, replacing it with a copy first if it is shared with a {@link TerminalBufferSnapshot}. */
+    private TerminalRow getRowForWriting(int internalRow) {
+        TerminalRow row = allocateFullLineIfNecessary(internalRow);
+        return row.mSharedWithSnapshot ? (mLines[internalRow] = new TerminalRow(row)) : row;
     }
 
     /**
@@ -220,7 +287,7 @@ public final class TerminalBuffer {
                 if (shiftDownOfTopRow != actualShift) {
                     // The new lines revealed by the resizing are not all from the transcript. Blank the below ones.
                     for (int i = 0; i < actualShift - shiftDownOfTopRow; i++)
-                        allocateFullLineIfNecessary((mScreenFirstRow + mScreenRows + i) % mTotalRows).clear(currentStyle);
+                        getRowForWriting((mScreenFirstRow + mScreenRows + i) % mTotalRows).clear(currentStyle);
                     shiftDownOfTopRow = actualShift;
                 }
             }
@@ -398,7 +465,7 @@ public final class TerminalBuffer {
 
         // Blank the newly revealed line above the bottom margin:
         int blankRow = externalToInternalRow(bottomMargin - 1);
-        if (mLines[blankRow] == null) {
+        if (mLines[blankRow] == null || mLines[blankRow].mSharedWithSnapshot) {
             mLines[blankRow] = new TerminalRow(mColumns, style);
         } else {
             mLines[blankRow].clear(style);
@@ -425,7 +492,7 @@ public final class TerminalBuffer {
         for (int y = 0; y < h; y++) {
             int y2 = copyingUp ? y : (h - (y + 1));
             TerminalRow sourceRow = allocateFullLineIfNecessary(externalToInternalRow(sy + y2));
-            allocateFullLineIfNecessary(externalToInternalRow(dy + y2)).copyInterval(sourceRow, sx, sx + w, dx);
+            getRowForWriting(externalToInternalRow(dy + y2)).copyInterval(sourceRow, sx, sx + w, dx);
         }
     }
 
@@ -452,7 +519,7 @@ public final class TerminalBuffer {
         if (row  < 0 || row >= mScreenRows || column < 0 || column >= mColumns)
             throw new IllegalArgumentException("TerminalBuffer.setChar(): row=" + row + ", column=" + column + ", mScreenRows=" + mScreenRows + ", mColumns=" + mColumns);
         row = externalToInternalRow(row);
-        allocateFullLineIfNecessary(row).setChar(column, codePoint, style);
+        getRowForWriting(row).setChar(column, codePoint, style);
     }
 
     public long getStyleAt(int externalRow, int column) {
@@ -463,7 +530,7 @@ public final class TerminalBuffer {
     public void setOrClearEffect(int bits, boolean setOrClear, boolean reverse, boolean rectangular, int leftMargin, int rightMargin, int top, int left,
                                  int bottom, int right) {
         for (int y = top; y < bottom; y++) {
-            TerminalRow line = mLines[externalToInternalRow(y)];
+            TerminalRow line = getRowForWriting(externalToInternalRow(y));
             int startOfLine = (rectangular || y == top) ? left : leftMargin;
             int endOfLine = (rectangular || y + 1 == bottom) ? right : rightMargin;
             for (int x = startOfLine; x < endOfLine; x++) {
@@ -479,7 +546,7 @@ public final class TerminalBuffer {
                 } else {
                     effect &= ~bits;
                 }
-                line.mStyle[x] = TextStyle.encode(foreColor, backColor, effect);
+                line.setStyle(x, TextStyle.encode(foreColor, backColor, effect));
             }
         }
     }
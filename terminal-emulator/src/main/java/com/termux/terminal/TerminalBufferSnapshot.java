@@ -0,0 +1,145 @@
+package com.termux.terminal;
+
+import java.io.IOException;
+import java.io.Writer;
+import java.util.ArrayList;
+
+/**
+ * An immutable snapshot of the transcript and screen of a {@link TerminalBuffer}, created with
+ * {@link TerminalBuffer#createSnapshot()}.
+ * <p>
+ * The snapshot shares its {@link TerminalRow}:s with the buffer, which copies a shared row before modifying it, so
+ * the snapshot can be read from any thread, like for exporting or searching a large transcript in the background,
+ * while the emulator keeps processing output on the main thread.
+ * <p>
+ * Rows use the same external coordinate system as {@link TerminalBuffer}, from -{@link #getActiveTranscriptRows()}
+ * to {@link #getScreenRows()}-1.
+ */
+public final class TerminalBufferSnapshot {
+
+    /** The rows from the oldest transcript row to the last screen row. */
+    private final TerminalRow[] mRows;
+    private final int mColumns;
+    private final int mScreenRows;
+    private final int mActiveTranscriptRows;
+
+    TerminalBufferSnapshot(TerminalRow[] rows, int columns, int screenRows, int activeTranscriptRows) {
+        mRows = rows;
+        mColumns = columns;
+        mScreenRows = screenRows;
+        mActiveTranscriptRows = activeTranscriptRows;
+    }
+
+    public int getColumns() {
+        return mColumns;
+    }
+
+    public int getScreenRows() {
+        return mScreenRows;
+    }
+
+    public int getActiveTranscriptRows() {
+        return mActiveTranscriptRows;
+    }
+
+    public int getActiveRows() {
+        return mRows.length;
+    }
+
+    public boolean getLineWrap(int row) {
+        return getRow(row).mLineWrap;
+    }
+
+    public long getStyleAt(int row, int column) {
+        return getRow(row).getStyle(column);
+    }
+
+    private TerminalRow getRow(int row) {
+        if (row < -mActiveTranscriptRows || row >= mScreenRows)
+            throw new IllegalArgumentException("row=" + row + ", mScreenRows=" + mScreenRows + ", mActiveTranscriptRows=" + mActiveTranscriptRows);
+        return mRows[row + mActiveTranscriptRows];
+    }
+
+    public String getTranscriptText() {
+        return getSelectedText(0, -mActiveTranscriptRows, mColumns, mScreenRows).trim();
+    }
+
+    public String getTranscriptTextWithoutJoinedLines() {
+        return getSelectedText(0, -mActiveTranscriptRows, mColumns, mScreenRows, false).trim();
+    }
+
+    public String getTranscriptTextWithFullLinesJoined() {
+        return getSelectedText(0, -mActiveTranscriptRows, mColumns, mScreenRows, true, true).trim();
+    }
+
+    public String getSelectedText(int selX1, int selY1, int selX2, int selY2) {
+        return getSelectedText(selX1, selY1, selX2, selY2, true);
+    }
+
+    public String getSelectedText(int selX1, int selY1, int selX2, int selY2, boolean joinBackLines) {
+        return getSelectedText(selX1, selY1, selX2, selY2, joinBackLines, false);
+    }
+
+    /** See {@link TerminalBuffer#getSelectedText(int, int, int, int, boolean, boolean)}. */
+    public String getSelectedText(int selX1, int selY1, int selX2, int selY2, boolean joinBackLines, boolean joinFullLines) {
+        final StringBuilder builder = new StringBuilder();
+
+        if (selY1 < -mActiveTranscriptRows) selY1 = -mActiveTranscriptRows;
+        if (selY2 >= mScreenRows) selY2 = mScreenRows - 1;
+
+        for (int row = selY1; row <= selY2; row++)
+            TerminalBuffer.appendSelectedRowText(builder, getRow(row), row, selX1, selY1, selX2, selY2, mColumns,
+                mScreenRows, joinBackLines, joinFullLines);
+        return builder.toString();
+    }
+
+    /**
+     * Get the text of only as many of the last rows as are needed for the last maxLength chars of the transcript text,
+     * not counting trailing blank rows, so that e.g. sharing a truncated transcript does not build the text of all rows.
+     * The text is the same as the end of {@link #getSelectedText(int, int, int, int, boolean, boolean)} for all rows,
+     * and is not trimmed.
+     */
+    public String getTranscriptTextTail(int maxLength, boolean joinBackLines, boolean joinFullLines) {
+        final ArrayList<String> rowTexts = new ArrayList<>();
+        final StringBuilder builder = new StringBuilder(2 * mColumns);
+        final int selY1 = -mActiveTranscriptRows;
+        final int selY2 = mScreenRows - 1;
+        int length = 0;
+        for (int row = selY2; row >= selY1 && length < maxLength; row--) {
+            builder.setLength(0);
+            TerminalBuffer.appendSelectedRowText(builder, getRow(row), row, 0, selY1, mColumns, selY2, mColumns,
+                mScreenRows, joinBackLines, joinFullLines);
+            rowTexts.add(builder.toString());
+            if (length > 0 || !isBlank(builder)) length += builder.length();
+        }
+
+        final StringBuilder text = new StringBuilder(length);
+        for (int i = rowTexts.size() - 1; i >= 0; i--)
+            text.append(rowTexts.get(i));
+        return text.toString();
+    }
+
+    private static boolean isBlank(CharSequence text) {
+        for (int i = 0; i < text.length(); i++)
+            if (text.charAt(i) > ' ') return false;
+        return true;
+    }
+
+    /**
+     * Write the text of the whole transcript and screen one row at a time, without building it as a single string. The
+     * text is the same as {@link #getSelectedText(int, int, int, int, boolean, boolean)} for all rows, so unlike
+     * {@link #getTranscriptText()} it is not trimmed.
+     */
+    public void writeTranscriptText(Writer writer, boolean joinBackLines, boolean joinFullLines) throws IOException {
+        final StringBuilder builder = new StringBuilder(2 * mColumns);
+        final int selY1 = -mActiveTranscriptRows;
+        final int selY2 = mScreenRows - 1;
+        for (int row = selY1; row <= selY2; row++) {
+            builder.setLength(0);
+            TerminalBuffer.appendSelectedRowText(builder, getRow(row), row, 0, selY1, mColumns, selY2, mColumns,
+                mScreenRows, joinBackLines, joinFullLines);
+            writer.append(builder);
+        }
+    }
+
+}
@@ -352,6 +352,25 @@ public final class TerminalEmulator {
         return mScreen == mAltBuffer;
     }
 
+    /** The number of rows, including the screen, that the main buffer can hold. */
+    public int getTranscriptRows() {
+        return mMainBuffer.getTotalRows();
+    }
+
+    /**
+     * Change the number of rows, including the screen, that the main buffer can hold. The oldest scroll history is
+     * dropped if shrinking. Values smaller than the screen are raised to the screen height.
+     */
+    public void setTranscriptRows(int transcriptRows) {
+        // The main buffer is only resized when switching back to it, so its screen may differ from mRows:
+        mMainBuffer.setTotalRows(Math.max(transcriptRows, Math.max(mRows, mMainBuffer.mScreenRows)));
+    }
+
+    /** Approximate number of heap bytes retained by the rows of the main and alternate buffers. */
+    public long getMemoryUsage() {
+        return mMainBuffer.getMemoryUsage() + mAltBuffer.getMemoryUsage();
+    }
+
     private int getTerminalTranscriptRows(Integer transcriptRows) {
         if (transcriptRows == null || transcriptRows < TERMINAL_TRANSCRIPT_ROWS_MIN || transcriptRows > TERMINAL_TRANSCRIPT_ROWS_MAX)
             return DEFAULT_TERMINAL_TRANSCRIPT_ROWS;
@@ -415,7 +434,8 @@ public final class TerminalEmulator {
 
     private void resizeScreen() {
         final int[] cursor = {mCursorCol, mCursorRow};
-        int newTotalRows = (mScreen == mAltBuffer) ? mRows : mMainBuffer.mTotalRows;
+        // The main buffer may have been trimmed down to its old screen rows, see setTranscriptRows(int):
+        int newTotalRows = (mScreen == mAltBuffer) ? mRows : Math.max(mMainBuffer.mTotalRows, mRows);
         mScreen.resize(mColumns, mRows, newTotalRows, cursor, getStyle(), isAlternateBufferActive());
         mCursorCol = cursor[0];
         mCursorRow = cursor[1];
@@ -2587,16 +2607,28 @@ public final class TerminalEmulator {
 
     /** If DECSET 2004 is set, prefix paste with "\033[200~" and suffix with "\033[201~". */
     public void paste(String text) {
-        // First: Always remove escape key and C1 control characters [0x80,0x9F]:
-        text = text.replaceAll("(\u001B|[\u0080-\u009F])", "");
-        // Second: Replace all newlines (\n) or CRLF (\r\n) with carriage returns (\r).
-        text = text.replaceAll("\r?\n", "\r");
-
-        // Then: Implement bracketed paste mode if enabled:
         boolean bracketed = isDecsetInternalBitSet(DECSET_BIT_BRACKETED_PASTE_MODE);
-        if (bracketed) mSession.write("\033[200~");
-        mSession.write(text);
-        if (bracketed) mSession.write("\033[201~");
+        // Sanitize and bracket in one pass, since pastes may be several megabytes. The session feeds the result to the
+        // process in chunks as it is consumed.
+        StringBuilder builder = new StringBuilder(text.length() + 12);
+        if (bracketed) builder.append("\033[200~");
+        boolean lastWasCarriageReturn = false;
+        for (int i = 0; i < text.length(); i++) {
+            char c = text.charAt(i);
+            if (c == '\u001B' || (c >= '\u0080' && c <= '\u009F')) {
+                // Always remove escape key and C1 control characters.
+                continue;
+            } else if (c == '\n') {
+                // Replace all newlines (\n) or CRLF (\r\n) with carriage returns (\r).
+                if (!lastWasCarriageReturn) builder.append('\r');
+                lastWasCarriageReturn = false;
+                continue;
+            }
+            builder.append(c);
+            lastWasCarriageReturn = c == '\r';
+        }
+        if (bracketed) builder.append("\033[201~");
+        mSession.writeLargeText(builder.toString());
     }
 
     /** http://www.vt100.net/docs/vt510-rm/DECSC */
@@ -0,0 +1,183 @@
+package com.termux.terminal;
+
+import android.content.ComponentCallbacks2;
+import android.os.SystemClock;
+
+import java.util.ArrayList;
+import java.util.Iterator;
+import java.util.LinkedHashMap;
+import java.util.List;
+
+/**
+ * Keeps the combined transcript memory of a set of {@link TerminalSession}s within a budget.
+ * <p>
+ * Sessions are kept in least recently used order, with the foreground session, see {@link #setForegroundSession},
+ * being the most recently used. When the total memory of all emulators exceeds the budget, the transcripts of
+ * background sessions are trimmed in least recently used order, but never below
+ * {@link TerminalEmulator#TERMINAL_TRANSCRIPT_ROWS_MIN} rows, while the foreground session always keeps its full
+ * transcript. A trimmed session gets its full transcript capacity back when it is brought to the foreground again, but
+ * the scroll history that was dropped is not restored.
+ * <p>
+ * All methods must be called on the main thread, which is the thread that mutates the terminal emulators.
+ */
+public final class TerminalMemoryGovernor {
+
+    /** The minimum interval between budget checks triggered by {@link #onSessionTextChanged(TerminalSession)}. */
+    public static final long CHECK_INTERVAL_MILLIS = 1000;
+
+    private static final class SessionEntry {
+        /** The transcript rows of the emulator when first seen, restored when the session is brought to foreground. */
+        int mFullTranscriptRows = -1;
+    }
+
+    /** The tracked sessions in least recently used order, so the foreground session is last. */
+    private final LinkedHashMap<TerminalSession, SessionEntry> mEntries = new LinkedHashMap<>();
+    private TerminalSession mForegroundSession;
+    private long mBudgetBytes;
+    private long mLastCheckTime;
+
+    /**
+     * @param budgetBytes The maximum number of bytes that the rows of all tracked emulators should retain.
+     */
+    public TerminalMemoryGovernor(long budgetBytes) {
+        mBudgetBytes = budgetBytes;
+    }
+
+    public long getBudget() {
+        return mBudgetBytes;
+    }
+
+    public void setBudget(long budgetBytes) {
+        mBudgetBytes = budgetBytes;
+        enforceBudget();
+    }
+
+    /**
+     * Start tracking a session as the most recently used background session, if not already tracked. This is the only
+     * way sessions are tracked, the other methods ignore sessions that are not, like ones already removed.
+     */
+    public void addSession(TerminalSession session) {
+        if (!mEntries.containsKey(session))
+            mEntries.put(session, new SessionEntry());
+    }
+
+    /** Stop tracking a session, which should be called when the session is removed. */
+    public void removeSession(TerminalSession session) {
+        mEntries.remove(session);
+        if (mForegroundSession == session) mForegroundSession = null;
+    }
+
+    public int getSessionCount() {
+        return mEntries.size();
+    }
+
+    public TerminalSession getForegroundSession() {
+        return mForegroundSession;
+    }
+
+    /**
+     * Make a session the foreground and most recently used session. If its transcript had been trimmed while in
+     * background, its full transcript capacity is restored. Ignored if the session is not tracked.
+     */
+    public void setForegroundSession(TerminalSession session) {
+        if (session == null) return;
+
+        SessionEntry entry = mEntries.remove(session);
+        if (entry == null) return;
+        mEntries.put(session, entry);
+        mForegroundSession = session;
+
+        TerminalEmulator emulator = session.getEmulator();
+        if (emulator != null && entry.mFullTranscriptRows > emulator.getTranscriptRows())
+            emulator.setTranscriptRows(entry.mFullTranscriptRows);
+    }
+
+    /** Approximate number of bytes retained by the emulator of a session, or 0 if it is not initialized yet. */
+    public static long getMemoryUsage(TerminalSession session) {
+        TerminalEmulator emulator = session.getEmulator();
+        return (emulator == null) ? 0 : emulator.getMemoryUsage();
+    }
+
+    /** Approximate number of bytes retained by the emulators of all tracked sessions. */
+    public long getTotalMemoryUsage() {
+        long total = 0;
+        for (TerminalSession session : mEntries.keySet())
+            total += getMemoryUsage(session);
+        return total;
+    }
+
+    /** The tracked sessions in least recently used order, so the foreground session is last. */
+    public List<TerminalSession> getSessions() {
+        return new ArrayList<>(mEntries.keySet());
+    }
+
+    /**
+     * Should be called when a session has received output. Checks the budget at most every
+     * {@link #CHECK_INTERVAL_MILLIS}, since computing the memory usage walks all rows of all sessions. Ignored if the
+     * session is not tracked, like for output published after the session was removed.
+     */
+    public void onSessionTextChanged(TerminalSession session) {
+        if (!mEntries.containsKey(session)) return;
+
+        long now = SystemClock.uptimeMillis();
+        if (mLastCheckTime != 0 && now - mLastCheckTime < CHECK_INTERVAL_MILLIS) return;
+        mLastCheckTime = now;
+        enforceBudget();
+    }
+
+    /**
+     * Should be called from {@link ComponentCallbacks2#onTrimMemory(int)}. Background sessions are trimmed to half the
+     * budget when the system is running low on memory, and to their minimum rows when memory is critical.
+     */
+    public void onTrimMemory(int level) {
+        if (level >= ComponentCallbacks2.TRIM_MEMORY_COMPLETE || level == ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL) {
+            enforceBudget(0);
+        } else if (level >= ComponentCallbacks2.TRIM_MEMORY_BACKGROUND || level == ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW) {
+            enforceBudget(mBudgetBytes / 2);
+        } else {
+            enforceBudget(mBudgetBytes);
+        }
+    }
+
+    /**
+     * Trim the transcripts of background sessions in least recently used order until the total memory usage is within
+     * the budget, or until all background sessions are down to {@link TerminalEmulator#TERMINAL_TRANSCRIPT_ROWS_MIN}
+     * rows. Trimming further would save little, and would leave a session with fewer rows than its screen has once it
+     * is resized taller.
+     *
+     * @return The total memory usage after trimming.
+     */
+    public long enforceBudget() {
+        return enforceBudget(mBudgetBytes);
+    }
+
+    private long enforceBudget(long budgetBytes) {
+        long total = 0;
+        for (TerminalSession session : mEntries.keySet()) {
+            TerminalEmulator emulator = session.getEmulator();
+            if (emulator == null) continue;
+            SessionEntry entry = mEntries.get(session);
+            if (entry.mFullTranscriptRows < 0) entry.mFullTranscriptRows = emulator.getTranscriptRows();
+            total += emulator.getMemoryUsage();
+        }
+
+        Iterator<TerminalSession> iterator = mEntries.keySet().iterator();
+        while (total > budgetBytes && iterator.hasNext()) {
+            TerminalSession session = iterator.next();
+            TerminalEmulator emulator = session.getEmulator();
+            if (session == mForegroundSession || emulator == null) continue;
+
+            // Halve the transcript at a time to keep as much history of the session as fits in the budget:
+            while (total > budgetBytes) {
+                int transcriptRows = emulator.getTranscriptRows();
+                long usageBefore = emulator.getMemoryUsage();
+                emulator.setTranscriptRows(Math.max(transcriptRows / 2, TerminalEmulator.TERMINAL_TRANSCRIPT_ROWS_MIN));
+                // Already down to the minimum rows, or to the screen rows if more:
+                if (emulator.getTranscriptRows() >= transcriptRows) break;
+                total -= usageBefore - emulator.getMemoryUsage();
+            }
+        }
+        return total;
+    }
+
+}
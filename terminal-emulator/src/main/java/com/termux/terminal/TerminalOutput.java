@@ -12,6 +12,14 @@ public abstract class TerminalOutput {
         write(bytes, 0, bytes.length);
     }
 
+    /**
+     * Write a possibly large text, like a paste, using the UTF-8 encoding to the terminal client. Clients may encode and
+     * send it in chunks as it is consumed instead of all at once.
+     */
+    public void writeLargeText(String text) {
+        write(text);
+    }
+
     /** Write bytes to the terminal client. */
     public abstract void write(byte[] data, int offset, int count);
 
@@ -6,6 +6,11 @@ import java.util.Arrays;
  * A row in a terminal, composed of a fixed number of cells.
  * <p>
  * The text in the row is stored in a char[] array, {@link #mText}, for quick access during rendering.
+ * <p>
+ * Styles are stored as one byte per cell indexing a small palette of the distinct styles used in the row, instead of
+ * one long per cell, since rows rarely use more than a handful of styles. A row whose cells use so many distinct styles
+ * that the palette would take more memory than one long per cell, like with per cell true color output, falls back to
+ * one long per cell until cleared.
  */
 public final class TerminalRow {
 
@@ -37,6 +42,15 @@ public final class TerminalRow {
      */
     private static final int MAX_COMBINING_CHARACTERS_PER_COLUMN = 15;
 
+    /** The max number of distinct styles that can be referenced by the byte indices of {@link #mStyleIndices}. */
+    private static final int MAX_STYLE_PALETTE_SIZE = 256;
+    private static final int INITIAL_STYLE_PALETTE_SIZE = 4;
+    /** The palette size above which styles are found with {@link #mStylePaletteLookup} instead of a linear scan. */
+    private static final int STYLE_PALETTE_LOOKUP_THRESHOLD = 16;
+
+    /** Approximate heap bytes of a row besides its arrays: the object itself plus the array headers. */
+    private static final int MEMORY_OVERHEAD_BYTES = 88;
+
     /** The number of columns in this terminal row. */
     private final int mColumns;
     /** The text filling this terminal row. */
@@ -45,19 +59,80 @@ public final class TerminalRow {
     private short mSpaceUsed;
     /** If this row has been line wrapped due to text output at the end of line. */
     boolean mLineWrap;
-    /** The style bits of each cell in the row. See {@link TextStyle}. */
-    final long[] mStyle;
+    /** The index in {@link #mStylePalette} of the style of each cell, or null if {@link #mStyles} is used instead. */
+    private byte[] mStyleIndices;
+    /** The distinct style bits used by the cells of the row, or null if {@link #mStyles} is used. See {@link TextStyle}. */
+    private long[] mStylePalette = new long[INITIAL_STYLE_PALETTE_SIZE];
+    /** The number of styles used in {@link #mStylePalette}. */
+    private int mStylePaletteSize;
+    /** The index in {@link #mStylePalette} of the style last found or added, checked first since styles come in runs. */
+    private int mLastStylePaletteIndex;
+    /**
+     * Open addressing hash table from style to its index in {@link #mStylePalette} plus one, or 0 for an empty slot,
+     * with twice as many slots as the palette has room for. Only allocated once the row uses more than
+     * {@link #STYLE_PALETTE_LOOKUP_THRESHOLD} styles, and only valid if {@link #mStylePaletteLookupValid}.
+     */
+    private short[] mStylePaletteLookup;
+    private boolean mStylePaletteLookupValid;
+    /** The style bits of each cell, only used if the row has too many styles for the palette to pay off. */
+    private long[] mStyles;
     /** If this row might contain chars with width != 1, used for deactivating fast path */
     boolean mHasNonOneWidthOrSurrogateChars;
+    /**
+     * The index in {@link #mText} where each column starts, see {@link #findStartOfColumn(int)}. Only built for rows
+     * with {@link #mHasNonOneWidthOrSurrogateChars}, and only valid if {@link #mColumnStartIndicesValid}.
+     */
+    private short[] mColumnStartIndices;
+    private boolean mColumnStartIndicesValid;
+    /**
+     * If this row is shared with a {@link TerminalBufferSnapshot}, in which case it must not be modified anymore and
+     * {@link TerminalBuffer} replaces it with a copy before modifying it. See {@link #setSharedWithSnapshot()}.
+     */
+    boolean mSharedWithSnapshot;
 
     /** Construct a blank row (containing only whitespace, ' ') with a specified style. */
     public TerminalRow(int columns, long style) {
         mColumns = columns;
         mText = new char[(int) (SPARE_CAPACITY_FACTOR * columns)];
-        mStyle = new long[columns];
+        mStyleIndices = new byte[columns];
         clear(style);
     }
 
+    /** Construct a copy of a row, used for modifying a row that is shared with a {@link TerminalBufferSnapshot}. */
+    TerminalRow(TerminalRow row) {
+        mColumns = row.mColumns;
+        mText = Arrays.copyOf(row.mText, row.mText.length);
+        mSpaceUsed = row.mSpaceUsed;
+        mLineWrap = row.mLineWrap;
+        mStyleIndices = (row.mStyleIndices == null) ? null : Arrays.copyOf(row.mStyleIndices, row.mStyleIndices.length);
+        mStylePalette = (row.mStylePalette == null) ? null : Arrays.copyOf(row.mStylePalette, row.mStylePalette.length);
+        mStylePaletteSize = row.mStylePaletteSize;
+        mLastStylePaletteIndex = row.mLastStylePaletteIndex;
+        mStyles = (row.mStyles == null) ? null : Arrays.copyOf(row.mStyles, row.mStyles.length);
+        mHasNonOneWidthOrSurrogateChars = row.mHasNonOneWidthOrSurrogateChars;
+    }
+
+    /**
+     * Mark this row as shared with a {@link TerminalBufferSnapshot}. Since a snapshot may be read from any thread, the
+     * lazily built column indices are built now, so that reading the row never modifies it.
+     */
+    void setSharedWithSnapshot() {
+        if (mSharedWithSnapshot) return;
+        if (mHasNonOneWidthOrSurrogateChars && !mColumnStartIndicesValid) buildColumnStartIndices();
+        mSharedWithSnapshot = true;
+    }
+
+    /** Approximate number of heap bytes retained by this row. */
+    public long getMemoryUsage() {
+        long bytes = MEMORY_OVERHEAD_BYTES + 2L * mText.length;
+        if (mStyleIndices != null) bytes += mStyleIndices.length;
+        if (mStylePalette != null) bytes += 8L * mStylePalette.length;
+        if (mStyles != null) bytes += 8L * mStyles.length;
+        if (mStylePaletteLookup != null) bytes += 2L * mStylePaletteLookup.length;
+        if (mColumnStartIndices != null) bytes += 2L * mColumnStartIndices.length;
+        return bytes;
+    }
+
     /** NOTE: The sourceX2 is exclusive. */
     public void copyInterval(TerminalRow line, int sourceX1, int sourceX2, int destinationX) {
         mHasNonOneWidthOrSurrogateChars |= line.mHasNonOneWidthOrSurrogateChars;
@@ -92,68 +167,82 @@ public final class TerminalRow {
     public int findStartOfColumn(int column) {
         if (column == mColumns) return getSpaceUsed();
 
-        int currentColumn = 0;
-        int currentCharIndex = 0;
-        while (true) { // 0<2 1 < 2
-            int newCharIndex = currentCharIndex;
-            char c = mText[newCharIndex++]; // cci=1, cci=2
-            boolean isHigh = Character.isHighSurrogate(c);
-            int codePoint = isHigh ? Character.toCodePoint(c, mText[newCharIndex++]) : c;
-            int wcwidth = WcWidth.width(codePoint); // 1, 2
-            if (wcwidth > 0) {
-                currentColumn += wcwidth;
-                if (currentColumn == column) {
-                    while (newCharIndex < mSpaceUsed) {
-                        // Skip combining chars.
-                        if (Character.isHighSurrogate(mText[newCharIndex])) {
-                            if (WcWidth.width(Character.toCodePoint(mText[newCharIndex], mText[newCharIndex + 1])) <= 0) {
-                                newCharIndex += 2;
-                            } else {
-                                break;
-                            }
-                        } else if (WcWidth.width(mText[newCharIndex]) <= 0) {
-                            newCharIndex++;
-                        } else {
-                            break;
-                        }
-                    }
-                    return newCharIndex;
-                } else if (currentColumn > column) {
-                    // Wide column going past end.
-                    return currentCharIndex;
-                }
-            }
-            currentCharIndex = newCharIndex;
-        }
+        // Without wide, combining or surrogate chars every column is a single java char:
+        if (!mHasNonOneWidthOrSurrogateChars) return column;
+
+        if (!mColumnStartIndicesValid) buildColumnStartIndices();
+        return mColumnStartIndices[column];
     }
 
-    private boolean wideDisplayCharacterStartingAt(int column) {
-        for (int currentCharIndex = 0, currentColumn = 0; currentCharIndex < mSpaceUsed; ) {
-            char c = mText[currentCharIndex++];
-            int codePoint = Character.isHighSurrogate(c) ? Character.toCodePoint(c, mText[currentCharIndex++]) : c;
+    /**
+     * Compute the start index of all columns in one pass over {@link #mText}. A column starts after the combining chars
+     * of the previous column, and the second half of a wide char starts at the wide char itself.
+     */
+    private void buildColumnStartIndices() {
+        if (mColumnStartIndices == null) mColumnStartIndices = new short[mColumns];
+        final char[] text = mText;
+        final short[] indices = mColumnStartIndices;
+
+        int column = 0;
+        int charIndex = 0;
+        while (charIndex < mSpaceUsed && column < mColumns) {
+            char c = text[charIndex];
+            int codePoint = Character.isHighSurrogate(c) ? Character.toCodePoint(c, text[charIndex + 1]) : c;
             int wcwidth = WcWidth.width(codePoint);
-            if (wcwidth > 0) {
-                if (currentColumn == column && wcwidth == 2) return true;
-                currentColumn += wcwidth;
-                if (currentColumn > column) return false;
+            if (wcwidth <= 0) {
+                // Combining char not following a base char.
+                charIndex += Character.charCount(codePoint);
+                continue;
             }
+
+            final int startOfColumn = charIndex;
+            charIndex += Character.charCount(codePoint);
+            // Skip combining chars, which belong to the base char before them.
+            while (charIndex < mSpaceUsed && WcWidth.width(text, charIndex) <= 0)
+                charIndex += Character.isHighSurrogate(text[charIndex]) ? 2 : 1;
+
+            for (int i = 0; i < wcwidth && column < mColumns; i++)
+                indices[column++] = (short) startOfColumn;
         }
-        return false;
+        while (column < mColumns)
+            indices[column++] = mSpaceUsed;
+
+        mColumnStartIndicesValid = true;
+    }
+
+    private boolean wideDisplayCharacterStartingAt(int column) {
+        if (!mHasNonOneWidthOrSurrogateChars || column < 0 || column >= mColumns) return false;
+
+        // The second half of a wide char starts at the same index as the first half:
+        final int startOfColumn = findStartOfColumn(column);
+        if (column > 0 && findStartOfColumn(column - 1) == startOfColumn) return false;
+        return startOfColumn < mSpaceUsed && WcWidth.width(mText, startOfColumn) == 2;
     }
 
     public void clear(long style) {
         Arrays.fill(mText, ' ');
-        Arrays.fill(mStyle, style);
+        if (mStyleIndices == null) {
+            mStyleIndices = new byte[mColumns];
+            mStylePalette = new long[INITIAL_STYLE_PALETTE_SIZE];
+            mStyles = null;
+        } else {
+            Arrays.fill(mStyleIndices, (byte) 0);
+        }
+        mStylePalette[0] = style;
+        mStylePaletteSize = 1;
+        mLastStylePaletteIndex = 0;
+        mStylePaletteLookupValid = false;
         mSpaceUsed = (short) mColumns;
         mHasNonOneWidthOrSurrogateChars = false;
+        mColumnStartIndicesValid = false;
     }
 
     // https://github.com/steven676/Android-Terminal-Emulator/commit/9a47042620bec87617f0b4f5d50568535668fe26
     public void setChar(int columnToSet, int codePoint, long style) {
-        if (columnToSet  < 0 || columnToSet >= mStyle.length)
+        if (columnToSet  < 0 || columnToSet >= mColumns)
             throw new IllegalArgumentException("TerminalRow.setChar(): columnToSet=" + columnToSet + ", codePoint=" + codePoint + ", style=" + style);
 
-        mStyle[columnToSet] = style;
+        setStyle(columnToSet, style);
 
         final int newCodePointDisplayWidth = WcWidth.width(codePoint);
 
@@ -215,6 +304,9 @@ public final class TerminalRow {
         int oldNextColumnIndex = oldStartOfColumnIndex + oldCharactersUsedForColumn;
         int newNextColumnIndex = oldStartOfColumnIndex + newCharactersUsedForColumn;
 
+        // The text is modified below, so the column indices need to be recomputed on next lookup:
+        mColumnStartIndicesValid = false;
+
         final int javaCharDifference = newCharactersUsedForColumn - oldCharactersUsedForColumn;
         if (javaCharDifference > 0) {
             // Shift the rest of the line right.
@@ -277,7 +369,147 @@ public final class TerminalRow {
     }
 
     public final long getStyle(int column) {
-        return mStyle[column];
+        return (mStyleIndices != null) ? mStylePalette[mStyleIndices[column] & 0xFF] : mStyles[column];
+    }
+
+    void setStyle(int column, long style) {
+        if (mStyleIndices == null) {
+            mStyles[column] = style;
+            return;
+        }
+        // Most cells are written with the style they already have, like after a clear:
+        if (mStylePalette[mStyleIndices[column] & 0xFF] == style) return;
+
+        int index = findOrAddPaletteStyle(style);
+        if (index < 0) {
+            // Switched to one style per cell, see findOrAddPaletteStyle().
+            mStyles[column] = style;
+        } else {
+            mStyleIndices[column] = (byte) index;
+        }
+    }
+
+    /**
+     * Find the index of a style in the palette, adding it if not already there. If the palette is full and neither
+     * growing it nor compacting it pays off, the row is switched to one style per cell and -1 is returned.
+     */
+    private int findOrAddPaletteStyle(long style) {
+        int index = findPaletteStyle(style);
+        if (index < 0) index = addPaletteStyle(style);
+        if (index >= 0) mLastStylePaletteIndex = index;
+        return index;
+    }
+
+    private int findPaletteStyle(long style) {
+        if (mStylePalette[mLastStylePaletteIndex] == style) return mLastStylePaletteIndex;
+
+        if (mStylePaletteSize <= STYLE_PALETTE_LOOKUP_THRESHOLD) {
+            for (int i = 0; i < mStylePaletteSize; i++)
+                if (mStylePalette[i] == style) return i;
+            return -1;
+        }
+
+        if (!mStylePaletteLookupValid) buildStylePaletteLookup();
+        final int mask = mStylePaletteLookup.length - 1;
+        for (int slot = hashStyle(style, mStylePaletteLookup.length); ; slot = (slot + 1) & mask) {
+            int entry = mStylePaletteLookup[slot];
+            if (entry == 0) return -1;
+            if (mStylePalette[entry - 1] == style) return entry - 1;
+        }
+    }
+
+    private int addPaletteStyle(long style) {
+        if (mStylePaletteSize == mStylePalette.length) {
+            final int capacity = 2 * mStylePalette.length;
+            if (capacity <= MAX_STYLE_PALETTE_SIZE && getStylePaletteMemoryUsage(capacity) <= 8L * mColumns) {
+                setStylePaletteCapacity(capacity);
+            } else {
+                // Growing would not pay off, so drop the styles no longer used by any cell instead. Unless that frees
+                // a quarter of the palette, compaction, which walks all cells, would be needed again soon:
+                compactStylePalette();
+                if (mStylePaletteSize > mStylePalette.length - mStylePalette.length / 4) {
+                    mStyles = new long[mColumns];
+                    for (int column = 0; column < mColumns; column++)
+                        mStyles[column] = mStylePalette[mStyleIndices[column] & 0xFF];
+                    mStyleIndices = null;
+                    mStylePalette = null;
+                    mStylePaletteLookup = null;
+                    mStylePaletteLookupValid = false;
+                    return -1;
+                }
+            }
+        }
+
+        mStylePalette[mStylePaletteSize] = style;
+        if (mStylePaletteLookupValid) addToStylePaletteLookup(mStylePaletteSize);
+        return mStylePaletteSize++;
+    }
+
+    /**
+     * The heap bytes used for storing the styles of the row with a palette of the given capacity, including the
+     * indices and the lookup, to compare against the 8 bytes per cell of {@link #mStyles}.
+     */
+    private long getStylePaletteMemoryUsage(int capacity) {
+        long bytes = mColumns + 8L * capacity;
+        if (capacity > STYLE_PALETTE_LOOKUP_THRESHOLD) bytes += 2L * 2 * capacity;
+        return bytes;
+    }
+
+    /** Resize the palette, keeping its styles. The lookup is rebuilt for the new size when next needed. */
+    private void setStylePaletteCapacity(int capacity) {
+        mStylePalette = Arrays.copyOf(mStylePalette, capacity);
+        mStylePaletteLookup = null;
+        mStylePaletteLookupValid = false;
+    }
+
+    private static int hashStyle(long style, int lookupLength) {
+        // Keep the top bits of the product, as many as needed for indexing the power of two lookup length:
+        return ((int) (style ^ (style >>> 32)) * 0x9E3779B9) >>> (Integer.numberOfLeadingZeros(lookupLength) + 1);
+    }
+
+    private void buildStylePaletteLookup() {
+        if (mStylePaletteLookup == null)
+            mStylePaletteLookup = new short[2 * mStylePalette.length];
+        else
+            Arrays.fill(mStylePaletteLookup, (short) 0);
+        for (int i = 0; i < mStylePaletteSize; i++)
+            addToStylePaletteLookup(i);
+        mStylePaletteLookupValid = true;
+    }
+
+    private void addToStylePaletteLookup(int index) {
+        final int mask = mStylePaletteLookup.length - 1;
+        int slot = hashStyle(mStylePalette[index], mStylePaletteLookup.length);
+        while (mStylePaletteLookup[slot] != 0)
+            slot = (slot + 1) & mask;
+        mStylePaletteLookup[slot] = (short) (index + 1);
+    }
+
+    /**
+     * Remove the styles from the palette that are no longer used by any cell, and shrink it to the smallest capacity
+     * that leaves a quarter of it free, but not above its current capacity.
+     */
+    private void compactStylePalette() {
+        final int[] newIndices = new int[MAX_STYLE_PALETTE_SIZE];
+        Arrays.fill(newIndices, -1);
+        final long[] newPalette = new long[mStylePalette.length];
+        int newSize = 0;
+        for (int column = 0; column < mColumns; column++) {
+            int oldIndex = mStyleIndices[column] & 0xFF;
+            if (newIndices[oldIndex] < 0) {
+                newIndices[oldIndex] = newSize;
+                newPalette[newSize++] = mStylePalette[oldIndex];
+            }
+            mStyleIndices[column] = (byte) newIndices[oldIndex];
+        }
+
+        int capacity = INITIAL_STYLE_PALETTE_SIZE;
+        while (capacity < newPalette.length && capacity - capacity / 4 < newSize + 1)
+            capacity *= 2;
+        mStylePalette = newPalette;
+        setStylePaletteCapacity(capacity);
+        mStylePaletteSize = newSize;
+        mLastStylePaletteIndex = 0;
     }
 
 }
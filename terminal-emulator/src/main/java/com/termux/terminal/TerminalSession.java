@@ -3,6 +3,7 @@ package com.termux.terminal;
 import android.annotation.SuppressLint;
 import android.os.Handler;
 import android.os.Message;
+import android.os.SystemClock;
 import android.system.ErrnoException;
 import android.system.Os;
 import android.system.OsConstants;
@@ -15,7 +16,10 @@ import java.io.IOException;
 import java.io.InputStream;
 import java.lang.reflect.Field;
 import java.nio.charset.StandardCharsets;
+import java.util.ArrayDeque;
+import java.util.Arrays;
 import java.util.UUID;
+import java.util.concurrent.atomic.AtomicReference;
 
 /**
  * A terminal session, consisting of a process coupled to a terminal interface.
@@ -32,6 +36,22 @@ public final class TerminalSession extends TerminalOutput {
 
     private static final int MSG_NEW_INPUT = 1;
     private static final int MSG_PROCESS_EXITED = 4;
+    private static final int MSG_FLOOD_FRAME = 5;
+
+    /**
+     * The max time spent processing output in one message while in flood mode, so that input events and drawing
+     * still get a chance to run on the main thread in between.
+     */
+    private static final int FLOOD_MODE_PROCESSING_BUDGET_MILLIS = 12;
+
+    /**
+     * The max number of bytes written with {@link #write(byte[], int, int)} that are deferred while the queue is full,
+     * like key presses and terminal replies queued behind a large paste. Input past this is dropped, so that a process
+     * requesting terminal replies without ever reading them cannot make the app run out of memory.
+     */
+    private static final int MAX_DEFERRED_INPUT_BYTES = 1024 * 1024;
+    /** The number of chars of a text written with {@link #writeLargeText(String)} that are encoded at a time. */
+    private static final int LARGE_TEXT_CHUNK_CHARS = 4096;
 
     public final String mHandle = UUID.randomUUID().toString();
 
@@ -44,9 +64,18 @@ public final class TerminalSession extends TerminalOutput {
     final ByteQueue mProcessToTerminalIOQueue = new ByteQueue(64 * 1024);
     /**
      * A queue written to from the main thread due to user interaction, and read by another thread which forwards by
-     * writing to the {@link #mTerminalFileDescriptor}.
+     * writing to the {@link #mTerminalFileDescriptor}. Written with {@link ByteQueue#writeWithoutBlocking(byte[], int, int)}
+     * so that large pastes never block the main thread while the process is slow to consume them, with what does not
+     * fit kept in {@link #mPendingInput}.
+     */
+    final ByteQueue mTerminalToProcessIOQueue = new ByteQueue(64 * 1024);
+    /**
+     * Input that did not fit in {@link #mTerminalToProcessIOQueue}, oldest first, which is fed to it by the writer thread
+     * as it drains the queue. Guarded by itself.
      */
-    final ByteQueue mTerminalToProcessIOQueue = new ByteQueue(4096);
+    private final ArrayDeque<PendingInput> mPendingInput = new ArrayDeque<>();
+    /** The number of bytes written with {@link #write(byte[], int, int)} in {@link #mPendingInput}. */
+    private int mDeferredInputBytes;
     /** Buffer to write translate code points into utf8 before writing to mTerminalToProcessIOQueue */
     private final byte[] mUtf8InputBuffer = new byte[5];
 
@@ -65,6 +94,9 @@ public final class TerminalSession extends TerminalOutput {
      */
     private int mTerminalFileDescriptor;
 
+    /** The recorder of the output of this session, if started with {@link #startRecording(File)}. */
+    private final AtomicReference<TerminalSessionRecorder> mRecorder = new AtomicReference<>();
+
     /** Set by the application for user identification of session, not by terminal. */
     public String mSessionName;
 
@@ -106,6 +138,56 @@ public final class TerminalSession extends TerminalOutput {
         } else {
             JNI.setPtyWindowSize(mTerminalFileDescriptor, rows, columns, cellWidthPixels, cellHeightPixels);
             mEmulator.resize(columns, rows, cellWidthPixels, cellHeightPixels);
+            recordResize();
+        }
+    }
+
+    /**
+     * Start recording the output of this session and its resizes to a file, which can be replayed with
+     * {@link TerminalSessionRecording}. Any recording already in progress is stopped first.
+     */
+    public void startRecording(File file) throws IOException {
+        stopRecording();
+        closeRecorder(mRecorder.getAndSet(new TerminalSessionRecorder(file)));
+        recordResize();
+    }
+
+    /** Stop recording started with {@link #startRecording(File)}, if any. */
+    public void stopRecording() {
+        closeRecorder(mRecorder.getAndSet(null));
+    }
+
+    /**
+     * Stop the recording only if it is still done by the given recorder, so that a recording started concurrently by
+     * another thread is not stopped. Returns whether it was stopped.
+     */
+    private boolean stopRecording(TerminalSessionRecorder expectedRecorder) {
+        if (!mRecorder.compareAndSet(expectedRecorder, null)) return false;
+        closeRecorder(expectedRecorder);
+        return true;
+    }
+
+    private void closeRecorder(TerminalSessionRecorder recorder) {
+        if (recorder == null) return;
+        try {
+            recorder.close();
+        } catch (IOException e) {
+            Logger.logStackTraceWithMessage(mClient, LOG_TAG, "Error closing session recording", e);
+        }
+    }
+
+    public boolean isRecording() {
+        return mRecorder.get() != null;
+    }
+
+    private void recordResize() {
+        TerminalSessionRecorder recorder = mRecorder.get();
+        if (recorder == null || mEmulator == null) return;
+        try {
+            recorder.recordResize(mEmulator.mColumns, mEmulator.mRows);
+        } catch (IOException e) {
+            if (stopRecording(recorder))
+                Logger.logStackTraceWithMessage(mClient, LOG_TAG, "Error recording session resize", e);
         }
     }
 
@@ -122,9 +204,12 @@ public final class TerminalSession extends TerminalOutput {
      */
     public void initializeEmulator(int columns, int rows, int cellWidthPixels, int cellHeightPixels) {
         mEmulator = new TerminalEmulator(this, columns, rows, cellWidthPixels, cellHeightPixels, mTranscriptRows, mClient);
+        recordResize();
 
         int[] processId = new int[1];
+        TerminalTrace.beginSection("JNI.createSubprocess");
         mTerminalFileDescriptor = JNI.createSubprocess(mShellPath, mCwd, mArgs, mEnv, processId, rows, columns, cellWidthPixels, cellHeightPixels);
+        TerminalTrace.endSection();
         mShellPid = processId[0];
         mClient.setTerminalShellPid(this, mShellPid);
 
@@ -138,8 +223,24 @@ public final class TerminalSession extends TerminalOutput {
                     while (true) {
                         int read = termIn.read(buffer);
                         if (read == -1) return;
-                        if (!mProcessToTerminalIOQueue.write(buffer, 0, read)) return;
-                        mMainThreadHandler.sendEmptyMessage(MSG_NEW_INPUT);
+                        TerminalSessionRecorder recorder = mRecorder.get();
+                        if (recorder != null) {
+                            try {
+                                recorder.recordOutput(buffer, 0, read);
+                            } catch (IOException e) {
+                                // Ignore if the recording was stopped or replaced concurrently from the main thread.
+                                if (stopRecording(recorder))
+                                    Logger.logStackTraceWithMessage(mClient, LOG_TAG, "Error recording session output", e);
+                            }
+                        }
+                        TerminalTrace.beginSection("ByteQueue.write");
+                        boolean written = mProcessToTerminalIOQueue.write(buffer, 0, read);
+                        TerminalTrace.endSection();
+                        if (!written) return;
+                        // No need to queue another message if the main thread has not yet handled the previous one,
+                        // as it drains everything written to the queue up to then.
+                        if (!mMainThreadHandler.hasMessages(MSG_NEW_INPUT))
+                            mMainThreadHandler.sendEmptyMessage(MSG_NEW_INPUT);
                     }
                 } catch (Exception e) {
                     // Ignore, just shutting down.
@@ -150,12 +251,16 @@ public final class TerminalSession extends TerminalOutput {
         new Thread("TermSessionOutputWriter[pid=" + mShellPid + "]") {
             @Override
             public void run() {
-                final byte[] buffer = new byte[4096];
+                // Large enough to forward a big paste in few write(2) calls.
+                final byte[] buffer = new byte[64 * 1024];
                 try (FileOutputStream termOut = new FileOutputStream(terminalFileDescriptorWrapped)) {
                     while (true) {
                         int bytesToWrite = mTerminalToProcessIOQueue.read(buffer, true);
                         if (bytesToWrite == -1) return;
+                        TerminalTrace.beginSection("pty write");
                         termOut.write(buffer, 0, bytesToWrite);
+                        TerminalTrace.endSection();
+                        feedPendingInput();
                     }
                 } catch (IOException e) {
                     // Ignore.
@@ -173,10 +278,70 @@ public final class TerminalSession extends TerminalOutput {
 
     }
 
-    /** Write data to the shell process. */
+    /**
+     * Write data to the shell process. Does not block, what does not fit in the queue to the process is deferred, or
+     * dropped if more than {@link #MAX_DEFERRED_INPUT_BYTES} are already deferred.
+     */
     @Override
     public void write(byte[] data, int offset, int count) {
-        if (mShellPid > 0) mTerminalToProcessIOQueue.write(data, offset, count);
+        if (mShellPid <= 0) return;
+        synchronized (mPendingInput) {
+            if (mPendingInput.isEmpty()) {
+                int bytesWritten = mTerminalToProcessIOQueue.writeWithoutBlocking(data, offset, count);
+                if (bytesWritten == -1 || bytesWritten == count) return;
+                offset += bytesWritten;
+                count -= bytesWritten;
+            }
+            if (mDeferredInputBytes + count > MAX_DEFERRED_INPUT_BYTES) {
+                Logger.logWarn(mClient, LOG_TAG, "Dropping " + count + " bytes of input not read by the process");
+                return;
+            }
+            mDeferredInputBytes += count;
+            mPendingInput.addLast(new PendingInput(Arrays.copyOfRange(data, offset, offset + count)));
+        }
+    }
+
+    /**
+     * Write a possibly large text, like a paste, to the shell process. Does not block, the text is encoded and fed to
+     * the process in chunks as it consumes it, so only a small part of it is buffered at any time.
+     */
+    @Override
+    public void writeLargeText(String text) {
+        if (mShellPid <= 0 || text == null || text.isEmpty()) return;
+        synchronized (mPendingInput) {
+            mPendingInput.addLast(new PendingInput(text));
+            feedPendingInput();
+        }
+    }
+
+    /** Move deferred input to {@link #mTerminalToProcessIOQueue} until it is full. */
+    private void feedPendingInput() {
+        synchronized (mPendingInput) {
+            PendingInput pending;
+            while ((pending = mPendingInput.peekFirst()) != null) {
+                if (pending.mBytesOffset == pending.mBytesEnd && !pending.encodeNextChunk()) {
+                    mPendingInput.removeFirst();
+                    continue;
+                }
+                int count = pending.mBytesEnd - pending.mBytesOffset;
+                int bytesWritten = mTerminalToProcessIOQueue.writeWithoutBlocking(pending.mBytes, pending.mBytesOffset, count);
+                if (bytesWritten == -1) {
+                    clearPendingInput();
+                    return;
+                }
+                pending.mBytesOffset += bytesWritten;
+                if (pending.mText == null) mDeferredInputBytes -= bytesWritten;
+                // The queue is full, the writer thread feeds the rest after draining it:
+                if (bytesWritten < count) return;
+            }
+        }
+    }
+
+    private void clearPendingInput() {
+        synchronized (mPendingInput) {
+            mPendingInput.clear();
+            mDeferredInputBytes = 0;
+        }
     }
 
     /** Write the Unicode code point to the terminal encoded in UTF-8. */
@@ -222,7 +387,9 @@ public final class TerminalSession extends TerminalOutput {
 
     /** Notify the {@link #mClient} that the screen has changed. */
     protected void notifyScreenUpdate() {
+        TerminalTrace.beginSection("TerminalSession.notifyScreenUpdate");
         mClient.onTextChanged(this);
+        TerminalTrace.endSection();
     }
 
     /** Reset state for terminal emulator state. */
@@ -253,6 +420,9 @@ public final class TerminalSession extends TerminalOutput {
         mTerminalToProcessIOQueue.close();
         mProcessToTerminalIOQueue.close();
         JNI.close(mTerminalFileDescriptor);
+        clearPendingInput();
+
+        stopRecording();
     }
 
     @Override
@@ -333,21 +503,76 @@ public final class TerminalSession extends TerminalOutput {
         return result;
     }
 
+    /** Input deferred until {@link #mTerminalToProcessIOQueue} has room, either bytes or a text encoded in chunks. */
+    private static final class PendingInput {
+        final String mText;
+        int mTextOffset;
+        byte[] mBytes;
+        int mBytesOffset;
+        int mBytesEnd;
+
+        PendingInput(byte[] bytes) {
+            mText = null;
+            mBytes = bytes;
+            mBytesEnd = bytes.length;
+        }
+
+        PendingInput(String text) {
+            mText = text;
+        }
+
+        /** Encode the next chunk of the text to {@link #mBytes}, returning false if there is nothing left. */
+        boolean encodeNextChunk() {
+            if (mText == null || mTextOffset == mText.length()) return false;
+            int end = Math.min(mText.length(), mTextOffset + LARGE_TEXT_CHUNK_CHARS);
+            // Do not split a surrogate pair between two chunks:
+            if (end < mText.length() && Character.isHighSurrogate(mText.charAt(end - 1))) end--;
+            mBytes = mText.substring(mTextOffset, end).getBytes(StandardCharsets.UTF_8);
+            mBytesOffset = 0;
+            mBytesEnd = mBytes.length;
+            mTextOffset = end;
+            return true;
+        }
+    }
+
+    /**
+     * Handler which processes output from the process on the main thread.
+     * <p>
+     * Normally the screen is updated after every chunk of output has been processed. When a process floods the
+     * terminal with more than {@link FloodModeDetector#BYTES_PER_FRAME_THRESHOLD} bytes within a frame, flood mode is
+     * entered: output keeps being processed into the buffer, but screen updates are deferred and published at most
+     * once every {@link FloodModeDetector#FRAME_INTERVAL_MILLIS}, skipping intermediate frames nobody could read
+     * anyway. Flood mode is left as soon as a frame sees output below the threshold again, or when the process exits.
+     */
     @SuppressLint("HandlerLeak")
     class MainThreadHandler extends Handler {
 
         final byte[] mReceiveBuffer = new byte[64 * 1024];
 
+        final FloodModeDetector mFloodModeDetector = new FloodModeDetector();
+
         @Override
         public void handleMessage(Message msg) {
-            int bytesRead = mProcessToTerminalIOQueue.read(mReceiveBuffer, false);
-            if (bytesRead > 0) {
-                mEmulator.append(mReceiveBuffer, bytesRead);
-                notifyScreenUpdate();
+            if (msg.what == MSG_FLOOD_FRAME) {
+                onFloodFrame();
+                return;
+            }
+
+            if (processInput(msg.what != MSG_PROCESS_EXITED) > 0) {
+                if (mFloodModeDetector.isFloodMode()) {
+                    if (!hasMessages(MSG_FLOOD_FRAME))
+                        sendEmptyMessageAtTime(MSG_FLOOD_FRAME, mFloodModeDetector.getFrameEndTime());
+                } else {
+                    notifyScreenUpdate();
+                }
             }
 
             if (msg.what == MSG_PROCESS_EXITED) {
                 int exitCode = (Integer) msg.obj;
+                // A pending flood mode frame must not publish the screen after the client was notified below, when the
+                // session may already have been removed. The screen is published once with the exit description instead.
+                removeMessages(MSG_FLOOD_FRAME);
+                mFloodModeDetector.reset();
                 cleanupResources(exitCode);
 
                 String exitDescription = "\r\n[Process completed";
@@ -368,6 +593,48 @@ public final class TerminalSession extends TerminalOutput {
             }
         }
 
+        /**
+         * Process output available in {@link #mProcessToTerminalIOQueue}.
+         *
+         * @param useBudget If processing should stop after {@link #FLOOD_MODE_PROCESSING_BUDGET_MILLIS} while in flood
+         *                  mode, in which case a {@link #MSG_NEW_INPUT} is queued to continue later.
+         * @return The number of bytes processed.
+         */
+        private int processInput(boolean useBudget) {
+            final long startTime = SystemClock.uptimeMillis();
+            int totalBytesRead = 0;
+            while (true) {
+                int bytesRead = mProcessToTerminalIOQueue.read(mReceiveBuffer, false);
+                if (bytesRead <= 0) break;
+                TerminalTrace.beginSection("TerminalEmulator.append");
+                mEmulator.append(mReceiveBuffer, bytesRead);
+                TerminalTrace.endSection();
+                totalBytesRead += bytesRead;
+
+                long now = SystemClock.uptimeMillis();
+                if (!mFloodModeDetector.onBytesProcessed(now, bytesRead)) break;
+                if (useBudget && now - startTime >= FLOOD_MODE_PROCESSING_BUDGET_MILLIS) {
+                    if (!hasMessages(MSG_NEW_INPUT)) sendEmptyMessage(MSG_NEW_INPUT);
+                    break;
+                }
+            }
+            return totalBytesRead;
+        }
+
+        /** Publish the screen state accumulated during a flood mode frame, and leave flood mode if output has slowed. */
+        private void onFloodFrame() {
+            notifyScreenUpdate();
+
+            if (!mFloodModeDetector.onFrame(SystemClock.uptimeMillis())) {
+                removeMessages(MSG_FLOOD_FRAME);
+                // Output may have arrived since the last frame without being processed due to the budget.
+                if (mProcessToTerminalIOQueue.isEmpty() || hasMessages(MSG_NEW_INPUT)) return;
+                sendEmptyMessage(MSG_NEW_INPUT);
+            } else if (!hasMessages(MSG_FLOOD_FRAME)) {
+                sendEmptyMessageAtTime(MSG_FLOOD_FRAME, mFloodModeDetector.getFrameEndTime());
+            }
+        }
+
     }
 
 }
@@ -0,0 +1,72 @@
+package com.termux.terminal;
+
+import java.io.BufferedOutputStream;
+import java.io.Closeable;
+import java.io.DataOutputStream;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+
+/**
+ * Records the output of a {@link TerminalSession} at the pty boundary, along with resize events, so that it can later
+ * be replayed through a {@link TerminalEmulator} with {@link TerminalSessionRecording}.
+ * <p>
+ * The file is append-only and consists of a header followed by records:
+ * <pre>
+ * header: magic (4 bytes, "TREC"), version (int)
+ * record: type (byte), time in nanoseconds since recording started (long), followed by
+ *   - {@link #RECORD_TYPE_OUTPUT}: length (int, at most {@link #MAX_OUTPUT_RECORD_LENGTH}), the raw bytes read from the pty
+ *   - {@link #RECORD_TYPE_RESIZE}: columns (int), rows (int)
+ * </pre>
+ * All values are big-endian as written by {@link DataOutputStream}.
+ * <p>
+ * Output is recorded from the session reader thread and resizes from the main thread, so all methods are synchronized.
+ */
+public final class TerminalSessionRecorder implements Closeable {
+
+    static final int MAGIC = ('T' << 24) | ('R' << 16) | ('E' << 8) | 'C';
+    static final int VERSION = 1;
+
+    static final byte RECORD_TYPE_OUTPUT = 1;
+    static final byte RECORD_TYPE_RESIZE = 2;
+
+    /** The max length of an output record, larger output is split into several records. */
+    static final int MAX_OUTPUT_RECORD_LENGTH = 1024 * 1024;
+
+    private final DataOutputStream mOutputStream;
+    private final long mStartTime = System.nanoTime();
+
+    public TerminalSessionRecorder(File file) throws IOException {
+        mOutputStream = new DataOutputStream(new BufferedOutputStream(new FileOutputStream(file), 64 * 1024));
+        mOutputStream.writeInt(MAGIC);
+        mOutputStream.writeInt(VERSION);
+    }
+
+    /** Record bytes read from the pty. */
+    public synchronized void recordOutput(byte[] data, int offset, int count) throws IOException {
+        final long time = System.nanoTime() - mStartTime;
+        while (count > 0) {
+            int recordLength = Math.min(count, MAX_OUTPUT_RECORD_LENGTH);
+            mOutputStream.writeByte(RECORD_TYPE_OUTPUT);
+            mOutputStream.writeLong(time);
+            mOutputStream.writeInt(recordLength);
+            mOutputStream.write(data, offset, recordLength);
+            offset += recordLength;
+            count -= recordLength;
+        }
+    }
+
+    /** Record a change of the terminal size. */
+    public synchronized void recordResize(int columns, int rows) throws IOException {
+        mOutputStream.writeByte(RECORD_TYPE_RESIZE);
+        mOutputStream.writeLong(System.nanoTime() - mStartTime);
+        mOutputStream.writeInt(columns);
+        mOutputStream.writeInt(rows);
+    }
+
+    @Override
+    public synchronized void close() throws IOException {
+        mOutputStream.close();
+    }
+
+}
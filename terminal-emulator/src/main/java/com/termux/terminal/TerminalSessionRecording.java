@@ -0,0 +1,80 @@
+package com.termux.terminal;
+
+import java.io.BufferedInputStream;
+import java.io.Closeable;
+import java.io.DataInputStream;
+import java.io.EOFException;
+import java.io.IOException;
+import java.io.InputStream;
+
+/**
+ * Reads a recording written by {@link TerminalSessionRecorder}, one record at a time.
+ * <p>
+ * After {@link #next()} has returned true the fields describing the current record are valid until the next call.
+ */
+public final class TerminalSessionRecording implements Closeable {
+
+    public static final int RECORD_TYPE_OUTPUT = TerminalSessionRecorder.RECORD_TYPE_OUTPUT;
+    public static final int RECORD_TYPE_RESIZE = TerminalSessionRecorder.RECORD_TYPE_RESIZE;
+
+    private final DataInputStream mInputStream;
+
+    /** The type of the current record, one of the RECORD_TYPE_* constants. */
+    public int mType;
+    /** The time of the current record in nanoseconds since the recording started. */
+    public long mTimeNanos;
+    /** The output of the current {@link #RECORD_TYPE_OUTPUT} record, of which {@link #mLength} bytes are valid. */
+    public byte[] mData = new byte[4096];
+    public int mLength;
+    /** The new size of the current {@link #RECORD_TYPE_RESIZE} record. */
+    public int mColumns, mRows;
+
+    public TerminalSessionRecording(InputStream inputStream) throws IOException {
+        mInputStream = new DataInputStream(new BufferedInputStream(inputStream, 64 * 1024));
+        if (mInputStream.readInt() != TerminalSessionRecorder.MAGIC)
+            throw new IOException("Not a terminal session recording");
+        int version = mInputStream.readInt();
+        if (version != TerminalSessionRecorder.VERSION)
+            throw new IOException("Unsupported terminal session recording version: " + version);
+    }
+
+    /**
+     * Read the next record.
+     *
+     * @return false if the end of the recording has been reached, including if the last record was truncated because
+     * the recording was not closed properly.
+     */
+    public boolean next() throws IOException {
+        try {
+            int type = mInputStream.read();
+            if (type == -1) return false;
+            mType = type;
+            mTimeNanos = mInputStream.readLong();
+            switch (type) {
+                case RECORD_TYPE_OUTPUT:
+                    mLength = mInputStream.readInt();
+                    // Check before allocating, so that a corrupt length cannot make the reader run out of memory:
+                    if (mLength < 0 || mLength > TerminalSessionRecorder.MAX_OUTPUT_RECORD_LENGTH)
+                        throw new IOException("Invalid output record length: " + mLength);
+                    if (mLength > mData.length) mData = new byte[mLength];
+                    mInputStream.readFully(mData, 0, mLength);
+                    break;
+                case RECORD_TYPE_RESIZE:
+                    mColumns = mInputStream.readInt();
+                    mRows = mInputStream.readInt();
+                    break;
+                default:
+                    throw new IOException("Unknown record type: " + type);
+            }
+            return true;
+        } catch (EOFException e) {
+            return false;
+        }
+    }
+
+    @Override
+    public void close() throws IOException {
+        mInputStream.close();
+    }
+
+}
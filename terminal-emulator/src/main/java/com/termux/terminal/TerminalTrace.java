@@ -0,0 +1,216 @@
+package com.termux.terminal;
+
+import java.io.IOException;
+import java.io.Writer;
+import java.lang.ref.WeakReference;
+import java.util.ArrayList;
+import java.util.Iterator;
+import java.util.List;
+import java.util.Locale;
+
+/**
+ * Low-overhead tracing of the hot paths of a terminal session (spawning, pty I/O, emulation and rendering), to find
+ * out where the time goes when a session feels slow.
+ * <p>
+ * Spans are recorded with {@link #beginSection(String)} and {@link #endSection()}, which must be called in pairs on
+ * the same thread, like {@link android.os.Trace}. Each thread records into its own fixed size ring buffer without any
+ * locking, overwriting its oldest events when full. When tracing is disabled, which is the default, each call costs a
+ * single volatile read. The buffers of threads that have died are dropped once exported or cleared, and at most
+ * {@link #MAX_DEAD_THREAD_BUFFERS} of them are kept until then, so short-lived threads do not accumulate.
+ * <p>
+ * Traces are exported with {@link #writeChromeTraceJson(Writer, int)} in the Chrome trace event format, which can be
+ * viewed with chrome://tracing or https://ui.perfetto.dev. Timestamps come from {@link System#nanoTime()}, which is
+ * CLOCK_MONOTONIC on Android and Linux.
+ */
+public final class TerminalTrace {
+
+    /** The number of events kept per thread. */
+    static final int EVENTS_PER_THREAD = 16 * 1024;
+    /** The max number of buffers of dead threads kept for export. */
+    static final int MAX_DEAD_THREAD_BUFFERS = 8;
+
+    private static volatile boolean sEnabled;
+
+    private static final List<ThreadBuffer> sThreadBuffers = new ArrayList<>();
+
+    private static final ThreadLocal<ThreadBuffer> sThreadBuffer = new ThreadLocal<ThreadBuffer>() {
+        @Override
+        protected ThreadBuffer initialValue() {
+            ThreadBuffer buffer = new ThreadBuffer(Thread.currentThread());
+            synchronized (sThreadBuffers) {
+                pruneDeadThreadBuffers(MAX_DEAD_THREAD_BUFFERS - 1);
+                sThreadBuffers.add(buffer);
+            }
+            return buffer;
+        }
+    };
+
+    /** The events of one thread, only written by that thread. */
+    static final class ThreadBuffer {
+        final WeakReference<Thread> mThread;
+        final long mThreadId;
+        final String mThreadName;
+        /** The name of each event, or null for the end of the latest begun section. */
+        final String[] mNames = new String[EVENTS_PER_THREAD];
+        final long[] mTimestamps = new long[EVENTS_PER_THREAD];
+        /** The total number of events ever recorded, of which the latest {@link #EVENTS_PER_THREAD} are kept. */
+        volatile long mCount;
+
+        ThreadBuffer(Thread thread) {
+            mThread = new WeakReference<>(thread);
+            mThreadId = thread.getId();
+            mThreadName = thread.getName();
+        }
+
+        void record(String name) {
+            long count = mCount;
+            int index = (int) (count % EVENTS_PER_THREAD);
+            mNames[index] = name;
+            mTimestamps[index] = System.nanoTime();
+            mCount = count + 1;
+        }
+
+        boolean isThreadAlive() {
+            Thread thread = mThread.get();
+            return thread != null && thread.isAlive();
+        }
+    }
+
+    private TerminalTrace() {
+    }
+
+    public static boolean isEnabled() {
+        return sEnabled;
+    }
+
+    /** Enable or disable tracing. Events already recorded are kept until {@link #clear()} is called. */
+    public static void setEnabled(boolean enabled) {
+        sEnabled = enabled;
+    }
+
+    /** Begin a span with the given name, which should be a constant to avoid allocations. */
+    public static void beginSection(String name) {
+        if (sEnabled) sThreadBuffer.get().record(name);
+    }
+
+    /** End the latest span begun with {@link #beginSection(String)} on this thread. */
+    public static void endSection() {
+        if (sEnabled) sThreadBuffer.get().record(null);
+    }
+
+    /** Discard all recorded events. Should only be called while tracing is disabled. */
+    public static void clear() {
+        synchronized (sThreadBuffers) {
+            pruneDeadThreadBuffers(0);
+            for (ThreadBuffer buffer : sThreadBuffers)
+                buffer.mCount = 0;
+        }
+    }
+
+    /** Drop the oldest buffers of dead threads until at most the given number is left. Must hold sThreadBuffers. */
+    private static void pruneDeadThreadBuffers(int maxDeadThreadBuffers) {
+        int deadThreadBuffers = 0;
+        for (ThreadBuffer buffer : sThreadBuffers)
+            if (!buffer.isThreadAlive()) deadThreadBuffers++;
+
+        Iterator<ThreadBuffer> iterator = sThreadBuffers.iterator();
+        while (deadThreadBuffers > maxDeadThreadBuffers && iterator.hasNext()) {
+            if (!iterator.next().isThreadAlive()) {
+                iterator.remove();
+                deadThreadBuffers--;
+            }
+        }
+    }
+
+    /**
+     * Write the recorded events as Chrome trace event JSON. Events being recorded concurrently by other threads may
+     * or may not be included. Only complete spans are written, so that the begin and end events of each thread are
+     * balanced even if tracing was toggled in the middle of a span or the start of a span was overwritten in the ring
+     * buffer. The buffers of threads that have died are dropped after being written.
+     *
+     * @param processId The process id to report the events under.
+     */
+    public static void writeChromeTraceJson(Writer writer, int processId) throws IOException {
+        List<ThreadBuffer> threadBuffers;
+        synchronized (sThreadBuffers) {
+            threadBuffers = new ArrayList<>(sThreadBuffers);
+        }
+
+        writer.write("{\"traceEvents\":[");
+        boolean first = true;
+        for (ThreadBuffer buffer : threadBuffers) {
+            long count = buffer.mCount;
+            long start = Math.max(0, count - EVENTS_PER_THREAD);
+            boolean[] complete = findCompleteEvents(buffer, start, count);
+            if (complete == null) continue;
+
+            if (!first) writer.write(',');
+            first = false;
+            writer.write("\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + processId + ",\"tid\":" + buffer.mThreadId
+                + ",\"args\":{\"name\":");
+            writeJsonString(writer, buffer.mThreadName);
+            writer.write("}}");
+
+            for (long i = start; i < count; i++) {
+                if (!complete[(int) (i - start)]) continue;
+                int index = (int) (i % EVENTS_PER_THREAD);
+                String name = buffer.mNames[index];
+                long timestamp = buffer.mTimestamps[index];
+                writer.write(",\n{\"ph\":\"" + (name == null ? 'E' : 'B') + "\",\"ts\":" + (timestamp / 1000) + "."
+                    + String.format(Locale.ROOT, "%03d", timestamp % 1000) + ",\"pid\":" + processId + ",\"tid\":" + buffer.mThreadId);
+                if (name != null) {
+                    writer.write(",\"name\":");
+                    writeJsonString(writer, name);
+                }
+                writer.write('}');
+            }
+        }
+        writer.write("\n]}\n");
+        writer.flush();
+
+        synchronized (sThreadBuffers) {
+            for (ThreadBuffer buffer : threadBuffers)
+                if (!buffer.isThreadAlive()) sThreadBuffers.remove(buffer);
+        }
+    }
+
+    /**
+     * Find the events in the range that belong to a span with both its begin and end event in the range, or null if
+     * there are none.
+     */
+    private static boolean[] findCompleteEvents(ThreadBuffer buffer, long start, long end) {
+        boolean[] complete = new boolean[(int) (end - start)];
+        int[] openBegins = new int[complete.length];
+        int depth = 0;
+        boolean any = false;
+        for (long i = start; i < end; i++) {
+            int offset = (int) (i - start);
+            if (buffer.mNames[(int) (i % EVENTS_PER_THREAD)] != null) {
+                openBegins[depth++] = offset;
+            } else if (depth > 0) {
+                // Ends without a begin in the range are skipped, as are begins left open at the end of the range.
+                complete[openBegins[--depth]] = true;
+                complete[offset] = true;
+                any = true;
+            }
+        }
+        return any ? complete : null;
+    }
+
+    private static void writeJsonString(Writer writer, String value) throws IOException {
+        writer.write('"');
+        for (int i = 0; i < value.length(); i++) {
+            char c = value.charAt(i);
+            if (c == '"' || c == '\\') {
+                writer.write('\\');
+                writer.write(c);
+            } else if (c < 0x20) {
+                writer.write(String.format(Locale.ROOT, "\\u%04x", (int) c));
+            } else {
+                writer.write(c);
+            }
+        }
+        writer.write('"');
+    }
+
+}
@@ -51,4 +51,30 @@ public class ByteQueueTest extends TestCase {
 		assertEquals(0, q.read(new byte[128], false));
 	}
 
+	public void testWriteWithoutBlockingWritesWhatFits() throws Exception {
+		ByteQueue q = new ByteQueue(4);
+		assertEquals(3, q.writeWithoutBlocking(new byte[]{1, 2, 3}, 0, 3));
+		assertEquals(1, q.writeWithoutBlocking(new byte[]{4, 5, 6}, 0, 3));
+		// Full:
+		assertEquals(0, q.writeWithoutBlocking(new byte[]{5}, 0, 1));
+
+		byte[] arr = new byte[3];
+		assertEquals(3, q.read(arr, true));
+		assertArrayEquals(new byte[]{1, 2, 3}, arr);
+		// Wraps around the end of the ring:
+		assertEquals(3, q.writeWithoutBlocking(new byte[]{0, 5, 6, 7}, 1, 3));
+
+		arr = new byte[10];
+		assertEquals(4, q.read(arr, true));
+		assertArrayEquals(new byte[]{4, 5, 6, 7, 0, 0, 0, 0, 0, 0}, arr);
+		assertTrue(q.isEmpty());
+		assertEquals(0, q.read(arr, false));
+	}
+
+	public void testWriteWithoutBlockingNotesClosing() throws Exception {
+		ByteQueue q = new ByteQueue(10);
+		q.close();
+		assertEquals(-1, q.writeWithoutBlocking(new byte[]{1, 2, 3}, 0, 3));
+	}
+
 }
@@ -0,0 +1,64 @@
+package com.termux.terminal;
+
+import junit.framework.TestCase;
+
+public class FloodModeDetectorTest extends TestCase {
+
+	private static final int FRAME = FloodModeDetector.FRAME_INTERVAL_MILLIS;
+	private static final int THRESHOLD = FloodModeDetector.BYTES_PER_FRAME_THRESHOLD;
+
+	private final FloodModeDetector mDetector = new FloodModeDetector();
+
+	public void testInteractiveOutputDoesNotEnter() {
+		long now = 1000;
+		for (int frame = 0; frame < 100; frame++, now += FRAME)
+			for (int i = 0; i < 4; i++)
+				assertFalse(mDetector.onBytesProcessed(now + i, THRESHOLD / 4));
+		assertFalse(mDetector.isFloodMode());
+	}
+
+	public void testEnterAboveThreshold() {
+		assertFalse(mDetector.onBytesProcessed(1000, THRESHOLD));
+		assertTrue(mDetector.onBytesProcessed(1000 + FRAME - 1, 1));
+		assertTrue(mDetector.isFloodMode());
+		assertEquals(1000 + FRAME, mDetector.getFrameEndTime());
+	}
+
+	public void testBytesOfEndedFrameDoNotCount() {
+		assertFalse(mDetector.onBytesProcessed(1000, THRESHOLD));
+		assertFalse(mDetector.onBytesProcessed(1000 + FRAME, THRESHOLD));
+		assertFalse(mDetector.isFloodMode());
+	}
+
+	public void testStayWhileFloodingAndExitAfterQuietFrames() {
+		long now = 1000;
+		assertTrue(mDetector.onBytesProcessed(now, 2 * THRESHOLD));
+		for (int frame = 0; frame < 10; frame++) {
+			now += FRAME;
+			assertTrue(mDetector.onBytesProcessed(now, 2 * THRESHOLD));
+			assertTrue(mDetector.onFrame(now + FRAME - 1));
+		}
+
+		// The frame right after the last flooded one still sees it as the previous frame:
+		now += FRAME;
+		assertTrue(mDetector.onFrame(now));
+		now += FRAME;
+		assertFalse(mDetector.onFrame(now));
+		assertFalse(mDetector.isFloodMode());
+	}
+
+	public void testExitAfterPause() {
+		assertTrue(mDetector.onBytesProcessed(1000, 2 * THRESHOLD));
+		// No frame was published for a while, so the flooded frame did not immediately precede the current one:
+		assertFalse(mDetector.onFrame(1000 + 3 * FRAME));
+	}
+
+	public void testReset() {
+		assertTrue(mDetector.onBytesProcessed(1000, 2 * THRESHOLD));
+		mDetector.reset();
+		assertFalse(mDetector.isFloodMode());
+		assertFalse(mDetector.onBytesProcessed(1001, 1));
+		assertFalse(mDetector.onFrame(1000 + FRAME));
+	}
+
+}
@@ -0,0 +1,142 @@
+package com.termux.terminal;
+
+import java.io.IOException;
+import java.io.StringWriter;
+import java.io.Writer;
+import java.util.Locale;
+
+public class TerminalBufferSnapshotTest extends TerminalTestCase {
+
+	public void testSnapshotIsNotAffectedByLaterOutput() {
+		withTerminalSized(5, 3).enterString("abcde\r\nfghij\r\nklm");
+		TerminalBufferSnapshot snapshot = mTerminal.getScreen().createSnapshot();
+		assertEquals("abcde\nfghij\nklm", snapshot.getTranscriptText());
+		long style = snapshot.getStyleAt(2, 1);
+
+		// Overwrite the screen, scroll and clear the screen, which modifies or reuses all shared rows:
+		enterString("\033[1;1HXY\033[7m\033[3;2HZ\r\n1\r\n2\r\n3\r\n4\r\n5");
+		enterString("\033[2J");
+		assertEquals("", mTerminal.getScreen().getSelectedText(0, 0, 5, 3).trim());
+
+		assertEquals("abcde\nfghij\nklm", snapshot.getTranscriptText());
+		assertEquals(0, snapshot.getActiveTranscriptRows());
+		assertEquals(3, snapshot.getActiveRows());
+		assertEquals(style, snapshot.getStyleAt(2, 1));
+	}
+
+	public void testSnapshotKeepsLineWrapAndWideChars() {
+		withTerminalSized(4, 2).enterString("abcdef").enterString("你好");
+		TerminalBufferSnapshot snapshot = mTerminal.getScreen().createSnapshot();
+		assertTrue(snapshot.getLineWrap(-1));
+		assertEquals("abcdef你好", snapshot.getTranscriptText());
+		assertEquals("abcd\nef你\n好", snapshot.getTranscriptTextWithoutJoinedLines());
+		assertEquals("好", snapshot.getSelectedText(0, 1, 1, 1));
+
+		enterString("\033[H\033[2Kå\r\n\r\n");
+		assertEquals("abcdef你好", snapshot.getTranscriptText());
+		assertEquals(mTerminal.getScreen().getTranscriptText(), mTerminal.getScreen().createSnapshot().getTranscriptText());
+	}
+
+	public void testSnapshotMatchesBuffer() throws IOException {
+		withTerminalSized(10, 4);
+		for (int i = 0; i < 50; i++)
+			enterString("line " + i + ((i % 3 == 0) ? " wraps around the edge" : "") + "\r\n");
+		TerminalBuffer buffer = mTerminal.getScreen();
+		TerminalBufferSnapshot snapshot = buffer.createSnapshot();
+
+		assertEquals(buffer.getActiveTranscriptRows(), snapshot.getActiveTranscriptRows());
+		assertEquals(buffer.getTranscriptText(), snapshot.getTranscriptText());
+		assertEquals(buffer.getTranscriptTextWithoutJoinedLines(), snapshot.getTranscriptTextWithoutJoinedLines());
+		assertEquals(buffer.getTranscriptTextWithFullLinesJoined(), snapshot.getTranscriptTextWithFullLinesJoined());
+		assertEquals(buffer.getSelectedText(2, -5, 6, 1), snapshot.getSelectedText(2, -5, 6, 1));
+
+		StringWriter writer = new StringWriter();
+		snapshot.writeTranscriptText(writer, true, false);
+		assertEquals(buffer.getSelectedText(0, -buffer.getActiveTranscriptRows(), 10, 4), writer.toString());
+	}
+
+	public void testTranscriptTextTail() {
+		withTerminalSized(10, 4);
+		for (int i = 0; i < 50; i++)
+			enterString("line " + i + ((i % 3 == 0) ? " wraps around the edge" : "") + "\r\n");
+		TerminalBufferSnapshot snapshot = mTerminal.getScreen().createSnapshot();
+		String transcript = snapshot.getSelectedText(0, -snapshot.getActiveTranscriptRows(), 10, 4, false, false);
+
+		// Enough rows for the last chars, counting from the last row with text:
+		String tail = snapshot.getTranscriptTextTail(30, false, false);
+		assertTrue(transcript.endsWith(tail));
+		assertTrue(tail.length() >= 30);
+		assertTrue(tail.length() < transcript.length());
+		assertTrue(tail.trim().endsWith("line 49"));
+
+		// The whole transcript if it is shorter than the max length:
+		assertEquals(transcript, snapshot.getTranscriptTextTail(100 * 1024, false, false));
+	}
+
+	public void testSnapshotReadWhileOutputContinues() throws Exception {
+		withTerminalSized(20, 5);
+		for (int i = 0; i < 500; i++)
+			enterString("before " + i + "\r\n");
+		final TerminalBufferSnapshot snapshot = mTerminal.getScreen().createSnapshot();
+		final String expected = snapshot.getTranscriptText();
+
+		final String[] readText = new String[1];
+		Thread reader = new Thread(() -> {
+			for (int i = 0; i < 20; i++)
+				readText[0] = snapshot.getTranscriptText();
+		});
+		reader.start();
+		for (int i = 0; i < 2000; i++)
+			mTerminal.append(("after " + i + "\r\n").getBytes(), ("after " + i + "\r\n").length());
+		reader.join();
+
+		assertEquals(expected, readText[0]);
+		assertTrue(expected.endsWith("before 499"));
+	}
+
+	/**
+	 * Measures the main thread stall of creating a snapshot and the time of exporting a full transcript from it. The
+	 * times are printed if the TERMUX_PRINT_BENCHMARKS environment variable is set to "true".
+	 */
+	public void testExportLargeTranscript() throws IOException {
+		final int lines = TerminalEmulator.TERMINAL_TRANSCRIPT_ROWS_MAX;
+		mTerminal = new TerminalEmulator(mOutput, 80, 24, 10, 20, lines, null);
+		StringBuilder output = new StringBuilder();
+		for (int i = 0; i < lines; i++)
+			output.append("exported line ").append(i).append("\r\n");
+		byte[] bytes = output.toString().getBytes();
+		mTerminal.append(bytes, bytes.length);
+
+		long start = System.nanoTime();
+		TerminalBufferSnapshot snapshot = mTerminal.getScreen().createSnapshot();
+		long snapshotNanos = System.nanoTime() - start;
+
+		// Output keeps modifying the buffer after the snapshot:
+		mTerminal.append(bytes, Math.min(bytes.length, 64 * 1024));
+
+		final int[] newlines = new int[1];
+		start = System.nanoTime();
+		snapshot.writeTranscriptText(new Writer() {
+			@Override
+			public void write(char[] buffer, int offset, int length) {
+				for (int i = offset; i < offset + length; i++)
+					if (buffer[i] == '\n') newlines[0]++;
+			}
+
+			@Override
+			public void flush() {
+			}
+
+			@Override
+			public void close() {
+			}
+		}, true, false);
+		long exportNanos = System.nanoTime() - start;
+
+		assertEquals(snapshot.getActiveRows() - 1, newlines[0]);
+		if ("true".equals(System.getenv("TERMUX_PRINT_BENCHMARKS")))
+			System.out.println(String.format(Locale.ROOT, "%d rows: snapshot %.2f ms, export %.2f ms",
+				snapshot.getActiveRows(), snapshotNanos / 1e6, exportNanos / 1e6));
+	}
+
+}
@@ -0,0 +1,178 @@
+package com.termux.terminal;
+
+import android.content.ComponentCallbacks2;
+
+import junit.framework.TestCase;
+
+import java.nio.charset.StandardCharsets;
+import java.util.ArrayList;
+import java.util.List;
+
+public class TerminalMemoryGovernorTest extends TestCase {
+
+	private static final int COLUMNS = 80;
+	private static final int ROWS = 24;
+	private static final int TRANSCRIPT_ROWS = 2000;
+	private static final int MIN_ROWS = TerminalEmulator.TERMINAL_TRANSCRIPT_ROWS_MIN;
+
+	private static TerminalSession createSession() {
+		TerminalSession session = new TerminalSession("/bin/sh", "/", new String[0], new String[0], TRANSCRIPT_ROWS, null);
+		session.mEmulator = new TerminalEmulator(new TerminalTestCase.MockTerminalOutput(), COLUMNS, ROWS, 10, 20, TRANSCRIPT_ROWS, null);
+		return session;
+	}
+
+	private static void output(TerminalSession session, String prefix, int lines) {
+		for (int i = 0; i < lines; i++) {
+			byte[] bytes = (prefix + " line " + i + "\r\n").getBytes(StandardCharsets.UTF_8);
+			session.getEmulator().append(bytes, bytes.length);
+		}
+	}
+
+	public void testSetTotalRowsKeepsScreenAndNewestHistory() {
+		TerminalBuffer buffer = new TerminalBuffer(3, 10, 2);
+		for (int i = 0; i < 6; i++) {
+			buffer.scrollDownOneLine(0, 2, TextStyle.NORMAL);
+			buffer.setChar(0, 1, '0' + i, TextStyle.NORMAL);
+		}
+		assertEquals(6, buffer.getActiveTranscriptRows());
+		assertEquals("0\n1\n2\n3\n4\n5", buffer.getTranscriptText());
+
+		buffer.setTotalRows(4);
+		assertEquals(4, buffer.getTotalRows());
+		assertEquals(2, buffer.getActiveTranscriptRows());
+		assertEquals("2\n3\n4\n5", buffer.getTranscriptText());
+
+		// Scrolling in the trimmed buffer keeps the transcript within the new capacity:
+		buffer.scrollDownOneLine(0, 2, TextStyle.NORMAL);
+		buffer.setChar(0, 1, '6', TextStyle.NORMAL);
+		assertEquals(2, buffer.getActiveTranscriptRows());
+		assertEquals("3\n4\n5\n6", buffer.getTranscriptText());
+
+		buffer.setTotalRows(10);
+		assertEquals(2, buffer.getActiveTranscriptRows());
+		assertEquals("3\n4\n5\n6", buffer.getTranscriptText());
+	}
+
+	public void testForegroundSessionIsNotTrimmed() {
+		TerminalSession background = createSession();
+		TerminalSession foreground = createSession();
+		output(background, "background", 3 * TRANSCRIPT_ROWS);
+		output(foreground, "foreground", 3 * TRANSCRIPT_ROWS);
+
+		TerminalMemoryGovernor governor = new TerminalMemoryGovernor(0);
+		governor.addSession(background);
+		governor.addSession(foreground);
+		governor.setForegroundSession(foreground);
+		governor.enforceBudget();
+
+		assertEquals(MIN_ROWS, background.getEmulator().getTranscriptRows());
+		assertEquals(MIN_ROWS - ROWS, background.getEmulator().getScreen().getActiveTranscriptRows());
+		assertEquals(TRANSCRIPT_ROWS, foreground.getEmulator().getTranscriptRows());
+		assertEquals(TRANSCRIPT_ROWS - ROWS, foreground.getEmulator().getScreen().getActiveTranscriptRows());
+
+		// Switching sessions restores the transcript capacity of the new foreground session:
+		governor.setForegroundSession(background);
+		assertEquals(TRANSCRIPT_ROWS, background.getEmulator().getTranscriptRows());
+		output(background, "background", 100);
+		assertEquals(MIN_ROWS - ROWS + 100, background.getEmulator().getScreen().getActiveTranscriptRows());
+	}
+
+	public void testResizeTallerAfterTrimmingToScreenRows() {
+		TerminalSession session = createSession();
+		output(session, "before", 3 * ROWS);
+		TerminalEmulator emulator = session.getEmulator();
+		emulator.setTranscriptRows(ROWS);
+		assertEquals(ROWS, emulator.getTranscriptRows());
+		assertEquals(0, emulator.getScreen().getActiveTranscriptRows());
+
+		// Like attaching the trimmed session to a taller view:
+		emulator.resize(COLUMNS, 2 * ROWS, 10, 20);
+		assertEquals(2 * ROWS, emulator.mRows);
+		assertEquals(2 * ROWS, emulator.getScreen().mScreenRows);
+		assertTrue(emulator.getTranscriptRows() >= 2 * ROWS);
+		output(session, "after", 4 * ROWS);
+		assertEquals("after line " + (4 * ROWS - 1), emulator.getScreen().getSelectedText(0, 2 * ROWS - 2, COLUMNS, 2 * ROWS - 2).trim());
+
+		// Trimming while the alternate buffer is active and leaving it after resizing taller:
+		byte[] enterAltBuffer = "\033[?1049h".getBytes(StandardCharsets.UTF_8);
+		emulator.append(enterAltBuffer, enterAltBuffer.length);
+		emulator.setTranscriptRows(ROWS);
+		emulator.resize(COLUMNS, 3 * ROWS, 10, 20);
+		byte[] leaveAltBuffer = "\033[?1049l".getBytes(StandardCharsets.UTF_8);
+		emulator.append(leaveAltBuffer, leaveAltBuffer.length);
+		assertEquals(3 * ROWS, emulator.getScreen().mScreenRows);
+		assertTrue(emulator.getTranscriptRows() >= 3 * ROWS);
+		output(session, "last", 4 * ROWS);
+		assertEquals("last line " + (4 * ROWS - 1), emulator.getScreen().getSelectedText(0, 3 * ROWS - 2, COLUMNS, 3 * ROWS - 2).trim());
+	}
+
+	public void testStressFiftySessions() {
+		final int sessionCount = 50;
+		List<TerminalSession> sessions = new ArrayList<>();
+		for (int i = 0; i < sessionCount; i++)
+			sessions.add(createSession());
+
+		long fullSessionUsage;
+		{
+			TerminalSession probe = createSession();
+			output(probe, "probe", TRANSCRIPT_ROWS);
+			fullSessionUsage = TerminalMemoryGovernor.getMemoryUsage(probe);
+		}
+
+		// Room for the foreground session and five other full transcripts:
+		final long budget = 6 * fullSessionUsage;
+		TerminalMemoryGovernor governor = new TerminalMemoryGovernor(budget);
+		for (TerminalSession session : sessions)
+			governor.addSession(session);
+		TerminalSession foreground = sessions.get(sessionCount - 1);
+		governor.setForegroundSession(foreground);
+		assertEquals(sessionCount, governor.getSessionCount());
+
+		for (int round = 0; round < 4; round++) {
+			for (int i = 0; i < sessionCount; i++)
+				output(sessions.get(i), "session " + i + " round " + round, TRANSCRIPT_ROWS / 2);
+			long total = governor.enforceBudget();
+			assertEquals(governor.getTotalMemoryUsage(), total);
+			assertTrue("round " + round + ": " + total + " > " + budget, total <= budget);
+		}
+
+		// The foreground session keeps its full history, and the most recently used sessions were trimmed last:
+		assertEquals(TRANSCRIPT_ROWS, foreground.getEmulator().getTranscriptRows());
+		assertEquals(TRANSCRIPT_ROWS - ROWS, foreground.getEmulator().getScreen().getActiveTranscriptRows());
+		assertEquals(MIN_ROWS, sessions.get(0).getEmulator().getTranscriptRows());
+		assertTrue(sessions.get(sessionCount - 2).getEmulator().getTranscriptRows() > MIN_ROWS);
+
+		long sum = 0;
+		for (TerminalSession session : sessions)
+			sum += TerminalMemoryGovernor.getMemoryUsage(session);
+		assertEquals(governor.getTotalMemoryUsage(), sum);
+
+		// Critical memory pressure leaves only the minimum rows in background sessions:
+		governor.onTrimMemory(ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL);
+		for (TerminalSession session : sessions) {
+			if (session == foreground) continue;
+			assertEquals(MIN_ROWS, session.getEmulator().getTranscriptRows());
+			assertEquals(MIN_ROWS - ROWS, session.getEmulator().getScreen().getActiveTranscriptRows());
+		}
+		assertEquals(TRANSCRIPT_ROWS, foreground.getEmulator().getTranscriptRows());
+
+		governor.removeSession(foreground);
+		assertNull(governor.getForegroundSession());
+		assertEquals(sessionCount - 1, governor.getSessionCount());
+	}
+
+	public void testRemovedSessionIsNotTrackedAgain() {
+		TerminalSession session = createSession();
+		TerminalMemoryGovernor governor = new TerminalMemoryGovernor(Long.MAX_VALUE);
+		governor.addSession(session);
+		governor.removeSession(session);
+
+		// Like a screen update published after the session exited and was removed:
+		governor.onSessionTextChanged(session);
+		governor.setForegroundSession(session);
+		assertEquals(0, governor.getSessionCount());
+		assertNull(governor.getForegroundSession());
+		assertEquals(0, governor.getTotalMemoryUsage());
+	}
+
+}
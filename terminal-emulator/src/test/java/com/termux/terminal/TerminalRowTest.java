@@ -429,4 +429,103 @@ public class TerminalRowTest extends TestCase {
 		// assertEquals(' ', line.mText[line.findStartOfColumn(COLUMNS - 1)]);
 	}
 
+	/** Find the start of a column by scanning the text from the start, as done before column indices were cached. */
+	private static int scanForStartOfColumn(TerminalRow line, int columns, int column) {
+		if (column == columns) return line.getSpaceUsed();
+		char[] text = line.mText;
+		int currentColumn = 0;
+		int charIndex = 0;
+		while (true) {
+			int codePoint = Character.codePointAt(text, charIndex);
+			int startIndex = charIndex;
+			charIndex += Character.charCount(codePoint);
+			int width = WcWidth.width(codePoint);
+			if (width <= 0) continue;
+			currentColumn += width;
+			if (currentColumn > column) return startIndex;
+			if (currentColumn == column) {
+				while (charIndex < line.getSpaceUsed() && WcWidth.width(text, charIndex) <= 0)
+					charIndex += Character.charCount(Character.codePointAt(text, charIndex));
+				return charIndex;
+			}
+		}
+	}
+
+	public void testFindStartOfColumnMatchesScan() {
+		int[] codePoints = {'a', 'b', DIARESIS_CODEPOINT, ONE_JAVA_CHAR_DISPLAY_WIDTH_TWO_1, TWO_JAVA_CHARS_DISPLAY_WIDTH_TWO_1,
+			TWO_JAVA_CHARS_DISPLAY_WIDTH_ONE_1};
+		Random random = new Random(42);
+		for (int i = 0; i < 2000; i++) {
+			int codePoint = codePoints[random.nextInt(codePoints.length)];
+			int column = random.nextInt(WcWidth.width(codePoint) == 2 ? COLUMNS - 1 : COLUMNS);
+			row.setChar(column, codePoint, TextStyle.NORMAL);
+			for (int c = 0; c <= COLUMNS; c++)
+				assertEquals("column=" + c + " after " + i + " writes", scanForStartOfColumn(row, COLUMNS, c), row.findStartOfColumn(c));
+			if (i % 500 == 499) row.clear(TextStyle.NORMAL);
+		}
+	}
+
+	public void testStylePalette() {
+		// Overwriting a cell with many styles reuses the palette entries no longer in use:
+		for (int i = 0; i < 1000; i++) {
+			row.setChar(0, 'a', i);
+			row.setChar(1, 'b', -i);
+			assertEquals(i, row.getStyle(0));
+			assertEquals(-i, row.getStyle(1));
+			assertEquals(TextStyle.NORMAL, row.getStyle(2));
+		}
+
+		// More distinct styles than fit in the palette:
+		final int columns = 300;
+		TerminalRow wideRow = new TerminalRow(columns, TextStyle.NORMAL);
+		long paletteUsage = wideRow.getMemoryUsage();
+		for (int column = 0; column < columns; column++)
+			wideRow.setChar(column, 'x', 1000 + column);
+		for (int column = 0; column < columns; column++)
+			assertEquals(1000 + column, wideRow.getStyle(column));
+		assertTrue(wideRow.getMemoryUsage() > paletteUsage + 8 * (columns - 256));
+
+		wideRow.clear(TextStyle.NORMAL);
+		for (int column = 0; column < columns; column++)
+			assertEquals(TextStyle.NORMAL, wideRow.getStyle(column));
+		wideRow.setChar(5, 'y', 7);
+		assertEquals(7, wideRow.getStyle(5));
+		assertEquals(TextStyle.NORMAL, wideRow.getStyle(6));
+	}
+
+	public void testStylePaletteWithTrueColorPerCell() {
+		// Every cell gets a new true color style on every pass, like a gradient being animated:
+		final int columns = 80;
+		TerminalRow trueColorRow = new TerminalRow(columns, TextStyle.NORMAL);
+		// The styles should never take more memory than one long per cell, which a plain row does not need:
+		long maxUsage = trueColorRow.getMemoryUsage() + 8 * columns;
+		for (int pass = 0; pass < 20; pass++) {
+			for (int column = 0; column < columns; column++) {
+				trueColorRow.setChar(column, 'x', TextStyle.encode(0xff000000 | (pass << 16) | column, 0xff000000 | column, 0));
+				assertTrue(trueColorRow.getMemoryUsage() <= maxUsage);
+			}
+			for (int column = 0; column < columns; column++)
+				assertEquals(TextStyle.encode(0xff000000 | (pass << 16) | column, 0xff000000 | column, 0), trueColorRow.getStyle(column));
+		}
+
+		// The palette shrinks when compacted after going back to a few styles:
+		TerminalRow shrinkingRow = new TerminalRow(columns, TextStyle.NORMAL);
+		for (int column = 0; column < 20; column++)
+			shrinkingRow.setChar(column, 'x', 1 + column);
+		long manyStylesUsage = shrinkingRow.getMemoryUsage();
+		for (int column = 0; column < 20; column++)
+			shrinkingRow.setChar(column, 'x', TextStyle.NORMAL);
+		for (int i = 0; i < 20; i++)
+			shrinkingRow.setChar(0, 'x', 100 + i);
+		assertTrue(shrinkingRow.getMemoryUsage() < manyStylesUsage);
+		assertEquals(119, shrinkingRow.getStyle(0));
+		assertEquals(TextStyle.NORMAL, shrinkingRow.getStyle(1));
+
+		// Going back to a few styles after many:
+		for (int column = 0; column < columns; column++)
+			trueColorRow.setChar(column, 'y', (column % 2 == 0) ? TextStyle.NORMAL : 42);
+		for (int column = 0; column < columns; column++)
+			assertEquals((column % 2 == 0) ? TextStyle.NORMAL : 42, trueColorRow.getStyle(column));
+	}
+
 }
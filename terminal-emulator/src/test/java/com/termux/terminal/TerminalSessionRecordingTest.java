@@ -0,0 +1,208 @@
+package com.termux.terminal;
+
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.lang.reflect.Method;
+import java.nio.charset.StandardCharsets;
+import java.util.Arrays;
+import java.util.Locale;
+
+/**
+ * Tests for {@link TerminalSessionRecorder} and {@link TerminalSessionRecording}, and a replay driver for measuring
+ * emulator throughput on recorded sessions.
+ * <p>
+ * To replay a corpus of recordings, set the TERMUX_REPLAY_DIR environment variable to a directory containing them
+ * and run {@link #testReplayCorpus()}. Recordings are replayed as fast as possible, or with their original timing if
+ * TERMUX_REPLAY_REAL_TIME is set to "true". A line with MB/s and allocated bytes is printed for each recording.
+ */
+public class TerminalSessionRecordingTest extends TerminalTestCase {
+
+	public void testRecordAndReadBack() throws Exception {
+		File file = File.createTempFile("termux-recording", ".trec");
+		try {
+			try (TerminalSessionRecorder recorder = new TerminalSessionRecorder(file)) {
+				recorder.recordResize(80, 24);
+				byte[] output = "hello\r\nworld".getBytes(StandardCharsets.UTF_8);
+				recorder.recordOutput(output, 0, 5);
+				recorder.recordOutput(output, 5, output.length - 5);
+				recorder.recordResize(40, 12);
+			}
+
+			try (TerminalSessionRecording recording = new TerminalSessionRecording(new FileInputStream(file))) {
+				assertTrue(recording.next());
+				assertEquals(TerminalSessionRecording.RECORD_TYPE_RESIZE, recording.mType);
+				assertEquals(80, recording.mColumns);
+				assertEquals(24, recording.mRows);
+				long previousTime = recording.mTimeNanos;
+
+				assertTrue(recording.next());
+				assertEquals(TerminalSessionRecording.RECORD_TYPE_OUTPUT, recording.mType);
+				assertEquals("hello", new String(recording.mData, 0, recording.mLength, StandardCharsets.UTF_8));
+				assertTrue(recording.mTimeNanos >= previousTime);
+
+				assertTrue(recording.next());
+				assertEquals(TerminalSessionRecording.RECORD_TYPE_OUTPUT, recording.mType);
+				assertEquals("\r\nworld", new String(recording.mData, 0, recording.mLength, StandardCharsets.UTF_8));
+
+				assertTrue(recording.next());
+				assertEquals(TerminalSessionRecording.RECORD_TYPE_RESIZE, recording.mType);
+				assertEquals(40, recording.mColumns);
+				assertEquals(12, recording.mRows);
+
+				assertFalse(recording.next());
+			}
+		} finally {
+			//noinspection ResultOfMethodCallIgnored
+			file.delete();
+		}
+	}
+
+	public void testTruncatedRecording() throws Exception {
+		File file = File.createTempFile("termux-recording", ".trec");
+		try {
+			try (TerminalSessionRecorder recorder = new TerminalSessionRecorder(file)) {
+				recorder.recordOutput(new byte[]{'a', 'b', 'c'}, 0, 3);
+				recorder.recordOutput(new byte[]{'d', 'e', 'f'}, 0, 3);
+			}
+			try (RandomAccessFile randomAccessFile = new RandomAccessFile(file, "rw")) {
+				randomAccessFile.setLength(randomAccessFile.length() - 1);
+			}
+
+			try (TerminalSessionRecording recording = new TerminalSessionRecording(new FileInputStream(file))) {
+				assertTrue(recording.next());
+				assertEquals(3, recording.mLength);
+				assertFalse(recording.next());
+			}
+		} finally {
+			//noinspection ResultOfMethodCallIgnored
+			file.delete();
+		}
+	}
+
+	public void testCorruptRecordLength() throws Exception {
+		File file = File.createTempFile("termux-recording", ".trec");
+		try {
+			try (TerminalSessionRecorder recorder = new TerminalSessionRecorder(file)) {
+				recorder.recordOutput(new byte[]{'a', 'b', 'c'}, 0, 3);
+			}
+			// Overwrite the length of the record, which follows the header, type and time:
+			try (RandomAccessFile randomAccessFile = new RandomAccessFile(file, "rw")) {
+				randomAccessFile.seek(8 + 1 + 8);
+				randomAccessFile.writeInt(Integer.MAX_VALUE);
+			}
+
+			try (TerminalSessionRecording recording = new TerminalSessionRecording(new FileInputStream(file))) {
+				recording.next();
+				fail("Expected IOException");
+			} catch (IOException e) {
+				assertTrue(e.getMessage(), e.getMessage().contains("Invalid output record length"));
+			}
+		} finally {
+			//noinspection ResultOfMethodCallIgnored
+			file.delete();
+		}
+	}
+
+	public void testReplayMatchesDirectAppend() throws Exception {
+		File file = File.createTempFile("termux-recording", ".trec");
+		try {
+			String output = "\033[31mred\033[0m\r\nline two\r\n\033[2;3Hxy";
+			try (TerminalSessionRecorder recorder = new TerminalSessionRecorder(file)) {
+				recorder.recordResize(10, 5);
+				byte[] bytes = output.getBytes(StandardCharsets.UTF_8);
+				recorder.recordOutput(bytes, 0, bytes.length);
+			}
+
+			TerminalEmulator replayed = new TerminalEmulator(new MockTerminalOutput(), 20, 10, INITIAL_CELL_WIDTH_PIXELS,
+				INITIAL_CELL_HEIGHT_PIXELS, null, null);
+			replay(file, replayed, false);
+
+			withTerminalSized(10, 5).enterString(output);
+			assertEquals(mTerminal.getScreen().getTranscriptText(), replayed.getScreen().getTranscriptText());
+			assertEquals(mTerminal.getCursorRow(), replayed.getCursorRow());
+			assertEquals(mTerminal.getCursorCol(), replayed.getCursorCol());
+		} finally {
+			//noinspection ResultOfMethodCallIgnored
+			file.delete();
+		}
+	}
+
+	public void testReplayCorpus() throws Exception {
+		String corpusDir = System.getenv("TERMUX_REPLAY_DIR");
+		if (corpusDir == null) return;
+		boolean realTime = "true".equals(System.getenv("TERMUX_REPLAY_REAL_TIME"));
+
+		File[] recordings = new File(corpusDir).listFiles();
+		assertNotNull("Not a directory: " + corpusDir, recordings);
+		Arrays.sort(recordings);
+		for (File file : recordings) {
+			if (!file.isFile()) continue;
+			TerminalEmulator emulator = new TerminalEmulator(new MockTerminalOutput(), 80, 24, INITIAL_CELL_WIDTH_PIXELS,
+				INITIAL_CELL_HEIGHT_PIXELS, TerminalEmulator.DEFAULT_TERMINAL_TRANSCRIPT_ROWS, null);
+			System.out.println(file.getName() + ": " + replay(file, emulator, realTime));
+		}
+	}
+
+	/**
+	 * Replay a recording through an emulator.
+	 *
+	 * @param realTime If the original timing of the output should be kept, instead of replaying as fast as possible.
+	 * @return A line describing the throughput and allocations of the replay.
+	 */
+	static String replay(File file, TerminalEmulator emulator, boolean realTime) throws IOException, InterruptedException {
+		boolean countAllocations = getAllocatedBytes() >= 0;
+
+		long bytes = 0;
+		long emulationNanos = 0;
+		long allocatedBytes = 0;
+		int outputRecords = 0;
+		long startTime = System.nanoTime();
+		try (TerminalSessionRecording recording = new TerminalSessionRecording(new FileInputStream(file))) {
+			while (recording.next()) {
+				if (realTime) {
+					long sleepNanos = recording.mTimeNanos - (System.nanoTime() - startTime);
+					if (sleepNanos > 0) Thread.sleep(sleepNanos / 1_000_000, (int) (sleepNanos % 1_000_000));
+				}
+
+				long allocatedBefore = countAllocations ? getAllocatedBytes() : 0;
+				long before = System.nanoTime();
+				if (recording.mType == TerminalSessionRecording.RECORD_TYPE_OUTPUT) {
+					emulator.append(recording.mData, recording.mLength);
+					bytes += recording.mLength;
+					outputRecords++;
+				} else {
+					emulator.resize(recording.mColumns, recording.mRows, INITIAL_CELL_WIDTH_PIXELS, INITIAL_CELL_HEIGHT_PIXELS);
+				}
+				emulationNanos += System.nanoTime() - before;
+				if (countAllocations) allocatedBytes += getAllocatedBytes() - allocatedBefore;
+			}
+		}
+
+		double megabytesPerSecond = (emulationNanos == 0) ? 0 : (bytes / (1024.0 * 1024.0)) / (emulationNanos / 1e9);
+		return String.format(Locale.ROOT, "%d bytes in %d records, %.3f ms emulating, %.2f MB/s, %s allocated",
+			bytes, outputRecords, emulationNanos / 1e6, megabytesPerSecond,
+			countAllocations ? allocatedBytes + " bytes" : "unknown bytes");
+	}
+
+	private static Object sThreadMXBean;
+	private static Method sGetThreadAllocatedBytes;
+
+	/**
+	 * The number of bytes allocated by the current thread, or -1 if not supported by the JVM. Accessed through
+	 * reflection since java.lang.management is not part of the Android API the tests are compiled against.
+	 */
+	static long getAllocatedBytes() {
+		try {
+			if (sGetThreadAllocatedBytes == null) {
+				sThreadMXBean = Class.forName("java.lang.management.ManagementFactory").getMethod("getThreadMXBean").invoke(null);
+				sGetThreadAllocatedBytes = Class.forName("com.sun.management.ThreadMXBean").getMethod("getThreadAllocatedBytes", long.class);
+			}
+			return (Long) sGetThreadAllocatedBytes.invoke(sThreadMXBean, Thread.currentThread().getId());
+		} catch (Exception e) {
+			return -1;
+		}
+	}
+
+}
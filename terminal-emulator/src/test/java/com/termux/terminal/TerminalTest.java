@@ -134,6 +134,9 @@ public class TerminalTest extends TerminalTestCase {
 		enterString("\033[?2004l");
 		mTerminal.paste("hi");
 		assertEquals("hi", mOutput.getOutputAndClear());
+
+		mTerminal.paste("a\nb\r\nc\n\nd\033e\u0085f\r\033\ng");
+		assertEquals("a\rb\rc\r\rdef\rg", mOutput.getOutputAndClear());
 	}
 
 	public void testSelectGraphics() {
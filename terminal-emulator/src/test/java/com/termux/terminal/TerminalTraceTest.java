@@ -0,0 +1,106 @@
+package com.termux.terminal;
+
+import junit.framework.TestCase;
+
+import java.io.StringWriter;
+
+public class TerminalTraceTest extends TestCase {
+
+	@Override
+	protected void tearDown() throws Exception {
+		TerminalTrace.setEnabled(false);
+		TerminalTrace.clear();
+		super.tearDown();
+	}
+
+	private static String export() throws Exception {
+		StringWriter writer = new StringWriter();
+		TerminalTrace.writeChromeTraceJson(writer, 42);
+		return writer.toString();
+	}
+
+	public void testDisabledRecordsNothing() throws Exception {
+		TerminalTrace.clear();
+		TerminalTrace.beginSection("disabled");
+		TerminalTrace.endSection();
+		assertFalse(export().contains("disabled"));
+	}
+
+	public void testChromeTraceJson() throws Exception {
+		TerminalTrace.clear();
+		TerminalTrace.setEnabled(true);
+		TerminalTrace.beginSection("outer");
+		TerminalTrace.beginSection("inner \"quoted\"");
+		TerminalTrace.endSection();
+		TerminalTrace.endSection();
+		TerminalTrace.setEnabled(false);
+
+		String json = export();
+		assertTrue(json, json.startsWith("{\"traceEvents\":["));
+		assertTrue(json, json.trim().endsWith("]}"));
+		assertTrue(json, json.contains("\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":42,\"tid\":" + Thread.currentThread().getId()));
+		int outer = json.indexOf("\"name\":\"outer\"");
+		int inner = json.indexOf("\"name\":\"inner \\\"quoted\\\"\"");
+		assertTrue(json, outer != -1 && inner > outer);
+		assertEquals(2, json.split("\"ph\":\"B\"", -1).length - 1);
+		assertEquals(2, json.split("\"ph\":\"E\"", -1).length - 1);
+	}
+
+	public void testRingBufferKeepsLatestEvents() throws Exception {
+		TerminalTrace.clear();
+		TerminalTrace.setEnabled(true);
+		TerminalTrace.beginSection("first");
+		TerminalTrace.endSection();
+		for (int i = 0; i < TerminalTrace.EVENTS_PER_THREAD / 2; i++) {
+			TerminalTrace.beginSection("repeated");
+			TerminalTrace.endSection();
+		}
+		TerminalTrace.setEnabled(false);
+
+		String json = export();
+		assertFalse(json.contains("\"first\""));
+		assertEquals(TerminalTrace.EVENTS_PER_THREAD / 2, json.split("\"ph\":\"B\"", -1).length - 1);
+	}
+
+	public void testUnbalancedEventsAreSkipped() throws Exception {
+		TerminalTrace.clear();
+		TerminalTrace.beginSection("started while disabled");
+		TerminalTrace.setEnabled(true);
+		TerminalTrace.endSection();
+		TerminalTrace.beginSection("complete");
+		TerminalTrace.endSection();
+		TerminalTrace.beginSection("ended while disabled");
+		TerminalTrace.setEnabled(false);
+		TerminalTrace.endSection();
+
+		String json = export();
+		assertTrue(json, json.contains("\"complete\""));
+		assertFalse(json, json.contains("\"ended while disabled\""));
+		assertEquals(1, json.split("\"ph\":\"B\"", -1).length - 1);
+		assertEquals(1, json.split("\"ph\":\"E\"", -1).length - 1);
+	}
+
+	public void testDeadThreadBuffersAreDropped() throws Exception {
+		TerminalTrace.clear();
+		TerminalTrace.setEnabled(true);
+		for (int i = 0; i < 2 * TerminalTrace.MAX_DEAD_THREAD_BUFFERS; i++) {
+			Thread thread = new Thread("TraceTestThread" + i) {
+				@Override
+				public void run() {
+					TerminalTrace.beginSection("thread");
+					TerminalTrace.endSection();
+				}
+			};
+			thread.start();
+			thread.join();
+		}
+		TerminalTrace.setEnabled(false);
+
+		// Only the latest dead threads are kept, and they are dropped once exported:
+		String json = export();
+		assertFalse(json, json.contains("\"TraceTestThread0\""));
+		assertTrue(json, json.contains("\"TraceTestThread" + (2 * TerminalTrace.MAX_DEAD_THREAD_BUFFERS - 1) + "\""));
+		assertFalse(export().contains("TraceTestThread"));
+	}
+
+}
@@ -1,6 +1,7 @@
 #include <cstdio>
 #include <ctime>
 #include <cerrno>
+#include <cstring>
 #include <jni.h>
 #include <sstream>
 #include <string>
@@ -8,6 +9,7 @@
 
 #include <android/log.h>
 
+#include <linux/sockios.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -387,7 +389,7 @@ Java_com_termux_shared_net_socket_local_LocalSocketManager_readNative(JNIEnv *en
         }
 
         // Read data from socket
-        int ret = read(fd, current, bytes);
+        int ret = read(fd, current, bytes - bytesRead);
         if (ret == -1) {
             int errnoBackup = errno;
             env->ReleaseByteArrayElements(dataArray, data, 0);
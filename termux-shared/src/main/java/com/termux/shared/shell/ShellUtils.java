@@ -5,6 +5,7 @@ import androidx.annotation.Nullable;
 
 import com.termux.shared.file.FileUtils;
 import com.termux.terminal.TerminalBuffer;
+import com.termux.terminal.TerminalBufferSnapshot;
 import com.termux.terminal.TerminalEmulator;
 import com.termux.terminal.TerminalSession;
 
@@ -73,4 +74,20 @@ public class ShellUtils {
         return transcriptText;
     }
 
+    /**
+     * Get a snapshot of the transcript for {@link TerminalSession}, which can be read from any thread.
+     * Must be called on the main thread.
+     */
+    public static TerminalBufferSnapshot getTerminalSessionTranscriptSnapshot(TerminalSession terminalSession) {
+        if (terminalSession == null) return null;
+
+        TerminalEmulator terminalEmulator = terminalSession.getEmulator();
+        if (terminalEmulator == null) return null;
+
+        TerminalBuffer terminalBuffer = terminalEmulator.getScreen();
+        if (terminalBuffer == null) return null;
+
+        return terminalBuffer.createSnapshot();
+    }
+
 }
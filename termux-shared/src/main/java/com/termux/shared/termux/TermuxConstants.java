@@ -12,7 +12,7 @@ import java.util.Formatter;
 import java.util.List;
 
 /*
- * Version: v0.53.0
+ * Version: v0.54.0
  * SPDX-License-Identifier: MIT
  *
  * Changelog
@@ -282,6 +282,12 @@ import java.util.List;
  * - 0.53.0 (2025-01-12)
  *      - Renamed `TERMUX_API`, `TERMUX_STYLING`, `TERMUX_TASKER`, `TERMUX_WIDGET` classes with `_APP` suffix added.
  *      - Added `TERMUX_*_MAIN_ACTIVITY_NAME` and `TERMUX_*_LAUNCHER_ACTIVITY_NAME` constants to each app class.
+ *
+ * - 0.54.0 (2026-10-19)
+ *      - Added `TERMUX_APP.TERMUX_SERVICE.ACTION_TRACE_START`, `TERMUX_APP.TERMUX_SERVICE.ACTION_TRACE_STOP`,
+ *          `TERMUX_APP.TERMUX_SERVICE.EXTRA_TRACE_FILE_PATH` and `TERMUX_APP.TERMUX_SERVICE.DEFAULT_TRACE_FILE_PATH`.
+ *      - Added `TERMUX_APP.TERMUX_SERVICE.ACTION_RECORDING_START`, `TERMUX_APP.TERMUX_SERVICE.ACTION_RECORDING_STOP`,
+ *          `TERMUX_APP.TERMUX_SERVICE.EXTRA_RECORDING_FILE_PATH` and `TERMUX_APP.TERMUX_SERVICE.DEFAULT_RECORDING_FILE_PATH`.
  */
 
 /**
@@ -995,6 +1001,30 @@ public final class TermuxConstants {
             public static final String ACTION_WAKE_UNLOCK = TERMUX_PACKAGE_NAME + ".service_wake_unlock"; // Default: "com.termux.service_wake_unlock"
 
 
+            /** Intent action to make TERMUX_SERVICE start tracing terminal sessions with {@link com.termux.terminal.TerminalTrace} */
+            public static final String ACTION_TRACE_START = TERMUX_PACKAGE_NAME + ".service_trace_start"; // Default: "com.termux.service_trace_start"
+
+
+            /** Intent action to make TERMUX_SERVICE stop tracing and write the trace to a file */
+            public static final String ACTION_TRACE_STOP = TERMUX_PACKAGE_NAME + ".service_trace_stop"; // Default: "com.termux.service_trace_stop"
+            /** Intent {@code String} extra for the path of the Chrome trace JSON file written for the TERMUX_SERVICE.ACTION_TRACE_STOP intent */
+            public static final String EXTRA_TRACE_FILE_PATH = TERMUX_PACKAGE_NAME + ".trace.file_path"; // Default: "com.termux.trace.file_path"
+            /** The default path of the file written for the TERMUX_SERVICE.ACTION_TRACE_STOP intent */
+            public static final String DEFAULT_TRACE_FILE_PATH = TERMUX_HOME_DIR_PATH + "/termux-trace.json"; // Default: "/data/data/com.termux/files/home/termux-trace.json"
+
+
+            /** Intent action to make TERMUX_SERVICE start recording the output of the current terminal session to a file */
+            public static final String ACTION_RECORDING_START = TERMUX_PACKAGE_NAME + ".service_recording_start"; // Default: "com.termux.service_recording_start"
+            /** Intent {@code String} extra for the path of the recording file written for the TERMUX_SERVICE.ACTION_RECORDING_START intent */
+            public static final String EXTRA_RECORDING_FILE_PATH = TERMUX_PACKAGE_NAME + ".recording.file_path"; // Default: "com.termux.recording.file_path"
+            /** The default path of the file written for the TERMUX_SERVICE.ACTION_RECORDING_START intent */
+            public static final String DEFAULT_RECORDING_FILE_PATH = TERMUX_HOME_DIR_PATH + "/termux-session.trec"; // Default: "/data/data/com.termux/files/home/termux-session.trec"
+
+
+            /** Intent action to make TERMUX_SERVICE stop recording all terminal sessions */
+            public static final String ACTION_RECORDING_STOP = TERMUX_PACKAGE_NAME + ".service_recording_stop"; // Default: "com.termux.service_recording_stop"
+
+
             /** Intent action to execute command with TERMUX_SERVICE */
             public static final String ACTION_SERVICE_EXECUTE = TERMUX_PACKAGE_NAME + ".service_execute"; // Default: "com.termux.service_execute"
 